@@ -0,0 +1,80 @@
+/*                   A X I S A L I G N E D B O X . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file AxisAlignedBox.h */
+
+#ifndef RT3_AXISALIGNEDBOX_H
+#define RT3_AXISALIGNEDBOX_H
+
+#include <QMatrix4x4>
+#include <QVector3D>
+#include <cfloat>
+
+// An axis aligned bounding box in model coordinates. A default constructed box is empty.
+struct AxisAlignedBox {
+    QVector3D minimum = QVector3D(FLT_MAX, FLT_MAX, FLT_MAX);
+    QVector3D maximum = QVector3D(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    bool isEmpty() const
+    {
+        return minimum.x() > maximum.x() || minimum.y() > maximum.y() || minimum.z() > maximum.z();
+    }
+
+    void add(const QVector3D& point)
+    {
+        minimum.setX(qMin(minimum.x(), point.x()));
+        minimum.setY(qMin(minimum.y(), point.y()));
+        minimum.setZ(qMin(minimum.z(), point.z()));
+        maximum.setX(qMax(maximum.x(), point.x()));
+        maximum.setY(qMax(maximum.y(), point.y()));
+        maximum.setZ(qMax(maximum.z(), point.z()));
+    }
+
+    void add(const AxisAlignedBox& box)
+    {
+        if (box.isEmpty()) return;
+        add(box.minimum);
+        add(box.maximum);
+    }
+
+    QVector3D center() const
+    {
+        return (minimum + maximum) / 2;
+    }
+
+    QVector3D size() const
+    {
+        return maximum - minimum;
+    }
+
+    // the box around the transformed corners of this box
+    AxisAlignedBox transformed(const QMatrix4x4& transform) const
+    {
+        AxisAlignedBox box;
+        if (isEmpty()) return box;
+        for (int corner = 0; corner < 8; corner++) {
+            box.add(transform.map(QVector3D(corner & 1 ? maximum.x() : minimum.x(),
+                                            corner & 2 ? maximum.y() : minimum.y(),
+                                            corner & 4 ? maximum.z() : minimum.z())));
+        }
+        return box;
+    }
+};
+
+#endif //RT3_AXISALIGNEDBOX_H
@@ -0,0 +1,71 @@
+/*          B O U N D I N G V O L U M E H I E R A R C H Y . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file BoundingVolumeHierarchy.h */
+
+#ifndef RT3_BOUNDINGVOLUMEHIERARCHY_H
+#define RT3_BOUNDINGVOLUMEHIERARCHY_H
+
+#include <QBitArray>
+#include <QVector>
+#include "AxisAlignedBox.h"
+#include "ViewFrustum.h"
+
+/*
+ * Bounding box tree of objects, used to find the objects in a view frustum without testing every object.
+ * Objects of each node's subtree are kept contiguous, so a node that is completely inside the frustum adds its
+ * objects without testing them.
+ */
+class BoundingVolumeHierarchy {
+public:
+    struct Item {
+        int objectId;
+        AxisAlignedBox box;
+    };
+
+    void build(const QVector<Item>& items);
+    void clear();
+
+    int size() const
+    {
+        return objectIds.size();
+    }
+
+    // sets the bits of the object ids (that are within the size of the array) inside or intersecting the frustum
+    void query(const ViewFrustum& frustum, QBitArray& objectsInFrustum) const;
+
+private:
+    struct Node {
+        AxisAlignedBox box;
+        int first;      // range of the objects of the subtree in objectIds
+        int count;
+        int left;       // child node indices, -1 for leaves. Right child is always left + 1
+    };
+
+    static const int maxLeafSize = 4;
+
+    QVector<Node> nodes;
+    QVector<int> objectIds;
+    QVector<AxisAlignedBox> boxes;  // box of each entry of objectIds
+
+    void buildNode(QVector<Item>& items, int first, int count, int nodeIndex);
+    void setBits(int first, int count, QBitArray& objectsInFrustum) const;
+};
+
+#endif //RT3_BOUNDINGVOLUMEHIERARCHY_H
@@ -0,0 +1,77 @@
+/*                      C O M M A N D L I N E . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file CommandLine.h */
+
+#ifndef RT3_COMMANDLINE_H
+#define RT3_COMMANDLINE_H
+
+#include <QColor>
+#include <QStringList>
+
+class Document;
+class OffscreenRenderer;
+
+/*
+ * Runs arbalest without a main window, for build machines and batch jobs. The documents are opened without widgets
+ * on screen and rendered with OffscreenRenderer.
+ *
+ *   arbalest --thumbnails <directory> [--size WxH] [--shaded] [--jobs N] file.g...
+ *     writes <directory>/<file>.png, an autoview of the visible objects of each file
+ *   arbalest --benchmark <frames> [--size WxH] [--shaded] file.g
+ *     renders a full turn around the model in the given number of frames and prints frame times as CSV
+ *   arbalest --raytrace <pattern> [--views standard,turntable] [--turntable-frames N] [--size WxH] [--anti-aliasing]
+ *            [--background color] file.g
+ *     raytraces the views into files named by the pattern (see RaytraceBatch) and prints the frames as CSV. Without
+ *     --views, the four standard views and a 36 frame turntable. The document still creates its OpenGL display
+ *     widgets, but they are never shown, so no OpenGL context is needed
+ *
+ * --software-gl renders with a software OpenGL implementation (opengl32sw on Windows, llvmpipe with Mesa). Without a
+ * display server (neither DISPLAY nor WAYLAND_DISPLAY set) and without QT_QPA_PLATFORM, the offscreen platform is
+ * used, so the widgets of the documents can be created. That is enough for --raytrace, rendering needs OpenGL and so
+ * xvfb-run (or a display server) for --thumbnails and --benchmark.
+ */
+class CommandLine {
+public:
+    // true if the arguments ask for a command line run instead of the main window
+    static bool isRequested(int argc, char* argv[]);
+    // application attributes that have to be set before QApplication is created
+    static void setApplicationAttributes(int argc, char* argv[]);
+
+    // parses QCoreApplication::arguments() and runs the command. Returns the exit code
+    int run();
+
+private:
+    int w = 0;
+    int h = 0;
+    bool shaded = false;
+    int jobs = 2;
+    int timeoutMs = 600000;
+
+    int runThumbnails(const QString& directory, const QStringList& filePaths);
+    int runBenchmark(int frames, const QString& filePath);
+    int runRaytrace(const QString& outputPattern, const QStringList& viewSets, int turntableFrames,
+                    bool antiAliasing, const QColor& background, const QString& filePath);
+
+    Document* openDocument(const QString& filePath, int documentId);
+    void closeDocument(Document* document);
+    OffscreenRenderer* createRenderer(Document* document);
+};
+
+#endif //RT3_COMMANDLINE_H
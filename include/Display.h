@@ -31,6 +31,8 @@
 #include <include/GridRenderer.h>
 #include "Document.h"
 #include "DisplayManager.h"
+#include "FrameStatistics.h"
+#include "ObjectPicker.h"
 #include "OrthographicCamera.h"
 #include "Globals.h"
 #include "QSSPreprocessor.h"
@@ -49,20 +51,31 @@ public:
     virtual ~Display();
 
     void forceRerenderFrame();
+    // draws the view into the current framebuffer of the current context. paintGL and OffscreenRenderer use this
+    void drawScene();
+    void setSize(int w, int h);
 
     int getW() const;
     int getH() const;
     const Document* getDocument() const;
     OrthographicCamera* getCamera() const;
     DisplayManager* getDisplayManager() const;
+    FrameStatistics* getFrameStatistics() const;
+    ObjectPicker* getObjectPicker() const;
 
     bool gridEnabled = false;
+    bool axesEnabled = true;
+    // draw surfaces instead of wireframes where the plot has them
+    bool shadedModeEnabled = false;
+    // frame statistics are collected while the overlay is shown or a CSV file is being written
+    bool statisticsOverlayEnabled = false;
 
 protected:
     void resizeGL(int w, int h) override;
     void paintGL() override;
 
     void keyPressEvent(QKeyEvent *k) override ;
+    void showEvent(QShowEvent *event) override;
 
 private:
     Document * document;
@@ -75,6 +88,8 @@ private:
     DisplayManager *displayManager;
     AxesRenderer * axesRenderer;
     GridRenderer * gridRenderer;
+    FrameStatistics * frameStatistics;
+    ObjectPicker * objectPicker;
 };
 
 
@@ -44,13 +44,15 @@ public:
     void resetAllViewPorts();
 
     void setMoveCameraMouseAction();
-private:
-    double defaultDisplayCameraRotation[4][3] = {
+
+    // angles around the axes of the displays' cameras after a reset
+    static constexpr double defaultDisplayCameraRotation[4][3] = {
             {0, 0, 270},
             {270, 0, 180},
             {270, 0, 270},
             {295, 0, 235}
     };
+private:
     Document*  document;
     QVector<Display *> displays;
     QVector<MouseAction *> mouseActions;
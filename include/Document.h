@@ -11,6 +11,7 @@
 #include "Properties.h"
 #include "GeometryRenderer.h"
 #include "DisplayGrid.h"
+#include "FrameScheduler.h"
 #include "VerificationValidationWidget.h"
 #include <include/RaytraceView.h>
 
@@ -18,6 +19,7 @@ class Properties;
 class Display;
 class GeometryRenderer;
 class DisplayGrid;
+class FrameScheduler;
 class RaytraceView;
 class ObjectTreeWidget;
 class MainWindow;
@@ -34,7 +36,13 @@ private:
     const int documentId;
     ObjectTree* objectTree;
     GeometryRenderer * geometryRenderer;
+    FrameScheduler * frameScheduler;
     bool modified;
+    quint64 databaseRevision = 0;
+    // the paths selected in the database (sorted) and the revision they were selected in, see selectObjects
+    quint64 selectedPathsSignature = 0;
+    QStringList selectedPaths;
+    quint64 selectedPathsRevision = 0;
 
 
 public:
@@ -92,18 +100,47 @@ public:
     {
 	    return objectTree;
     }
-    GeometryRenderer *getGeometryRenderer(){
+    GeometryRenderer *getGeometryRenderer() const {
         return geometryRenderer;
     }
 
+    // all redraws of the document's displays go through this
+    FrameScheduler *getFrameScheduler() const {
+        return frameScheduler;
+    }
+
     void setFilePath(const QString& filePath)
     {
         this->filePath = new QString(filePath);
     }
 
     bool isModified();
+    // changes whenever an object of the database is added or modified
+    quint64 getDatabaseRevision() const
+    {
+        return databaseRevision;
+    }
     bool Add(const BRLCAD::Object& object);
     bool Save(const char* fileName);
+    // writes the database to fileName without changing the document's file or modified state
+    bool saveCopy(const QString& fileName);
+    bool containsObject(const QString& objectName);
+    // a copy of the object, which the caller deletes. nullptr if there is no such object
+    BRLCAD::Object* getObjectCopy(const QString& objectName);
+    // adds the top level object to the object tree, after Add put it into the database
+    int addTopObject(const QString& name);
+
+    // full paths of the fully visible objects, not descending into them
+    QStringList getVisibleObjectPaths();
+    // Selects the objects at paths in the database, for its bounding box and raytracing. Nothing is done if the same
+    // paths are selected already and the database did not change, so librt keeps what it prepped for them
+    void selectObjects(const QStringList& paths);
+    // hash of a set of paths in a revision of the database, regardless of their order. Equal sets have equal
+    // signatures, different ones almost always differ
+    static quint64 selectionSignature(const QStringList& paths, quint64 databaseRevision);
+    // bounding box of the selected objects. librt may prep them for it
+    void getSelectionBoundingBox(BRLCAD::Vector3D& minima, BRLCAD::Vector3D& maxima);
+    // func runs while the database mutex is held, it must not lock it again
     void getBRLCADConstObject(const QString& objectName, const std::function<void(const BRLCAD::Object&)>& func);
     void getBRLCADObject(const QString& objectName, const std::function<void(BRLCAD::Object&)>& func);
 };
@@ -0,0 +1,59 @@
+/*                   F R A M E S C H E D U L E R . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file FrameScheduler.h */
+
+#ifndef RT3_FRAMESCHEDULER_H
+#define RT3_FRAMESCHEDULER_H
+
+#include <QHash>
+#include <QObject>
+
+class Display;
+
+/*
+ * Collects redraw requests for the displays of a Document. Requests made while handling an event are merged, a
+ * display is asked to repaint only if it is visible, and not again until its previous frame has been swapped (which
+ * with vsync happens at most once per refresh). Hidden displays keep their request until they are shown.
+ */
+class FrameScheduler : public QObject {
+    Q_OBJECT
+public:
+    explicit FrameScheduler(QObject* parent = nullptr);
+
+    void addDisplay(Display* display);
+
+    void requestFrame(Display* display);
+    void requestAllFrames();
+
+private:
+    struct DisplayState {
+        bool dirty = false;
+        bool frameInFlight = false;    // update() was called and the frame was not swapped yet
+    };
+
+    QHash<Display*, DisplayState> displayStates;
+    bool flushScheduled = false;
+
+    void scheduleFlush();
+    void flush();
+    void frameSwapped(Display* display);
+};
+
+#endif //RT3_FRAMESCHEDULER_H
@@ -0,0 +1,101 @@
+/*                  F R A M E S T A T I S T I C S . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file FrameStatistics.h */
+
+#ifndef RT3_FRAMESTATISTICS_H
+#define RT3_FRAMESTATISTICS_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+
+class QOpenGLTimerQuery;
+class QPainter;
+
+/*
+ * Timing and counters of the frames of a Display. CPU time is measured between beginFrame and endFrame, GPU time with
+ * timer queries whose results are read a few frames later so the CPU never waits for the GPU. GPU times are -1 when
+ * timer queries are not supported.
+ *
+ * Keeps the last sampleWindowSize frames for percentiles, and can write every frame to a CSV file.
+ */
+class FrameStatistics {
+public:
+    // filled in by the display before endFrame
+    struct Counters {
+        int drawCalls = 0;
+        int verticesSubmitted = 0;
+        int objectsDrawn = 0;
+        int objectsCulled = 0;
+        int plotQueueDepth = 0;
+    };
+
+    FrameStatistics();
+    ~FrameStatistics();
+
+    // must be called with the display's context current
+    void beginFrame();
+    void endFrame(const Counters& counters);
+    // releases the timer queries, call with the context current before it is destroyed
+    void releaseQueries();
+
+    double cpuPercentile(double percentile) const;
+    double gpuPercentile(double percentile) const;
+
+    void drawOverlay(QPainter& painter) const;
+
+    bool startCsv(const QString& filePath);
+    void stopCsv();
+    bool isWritingCsv() const
+    {
+        return csvFile.isOpen();
+    }
+
+private:
+    static const int sampleWindowSize = 240;
+    static const int queryCount = 4;
+
+    struct Sample {
+        qint64 frame;
+        double cpuMs;
+        double gpuMs;
+        Counters counters;
+    };
+
+    QElapsedTimer cpuTimer;
+    QOpenGLTimerQuery* queries[queryCount] = {};
+    bool queryPending[queryCount] = {};
+    qint64 queryFrame[queryCount] = {};
+    bool queriesSupported = true;
+
+    qint64 frame = 0;
+    QVector<Sample> samples;    // ring buffer of the last frames, indexed by frame % sampleWindowSize
+
+    QFile csvFile;
+    QTextStream csv;
+
+    Sample* findSample(qint64 sampleFrame);
+    void collectQueryResults();
+    void writeCsvLine(const Sample& sample);
+    double percentile(double Sample::*value, double percentile) const;
+};
+
+#endif //RT3_FRAMESTATISTICS_H
@@ -0,0 +1,109 @@
+/*                      G E O M E T R Y B A T C H . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file GeometryBatch.h */
+
+#ifndef RT3_GEOMETRYBATCH_H
+#define RT3_GEOMETRYBATCH_H
+
+#include <QBitArray>
+#include <QMap>
+#include <QOpenGLBuffer>
+#include <QOpenGLShaderProgram>
+#include "PlotGeometry.h"
+
+class DisplayManager;
+
+/*
+ * All plotted objects that are drawn with the same color. Their wireframes are kept in one vertex buffer and one
+ * index buffer which are uploaded only when an object is added or removed. Changing the visibility of objects only
+ * changes which index ranges are drawn. Surfaces (see PlotGeometry) are kept in a second pair of buffers and drawn
+ * instead of the wireframe in shaded mode.
+ *
+ * Buffers are created in the OpenGL context that is current when upload() is called. Since all contexts share with
+ * the global share context, they are uploaded once and drawn by all displays.
+ */
+class GeometryBatch {
+public:
+    explicit GeometryBatch(const float color[3]);
+
+    void addObject(int objectId, const PlotGeometry& geometry);
+    void removeObject(int objectId);
+    bool contains(int objectId) const;
+    bool isEmpty() const;
+
+    // true if objects were added or removed since last upload
+    bool isDirty() const;
+    void upload();
+    void destroyBuffers();
+
+    // Recomputes the index ranges to draw. Both arguments are indexed by object id, objectLevels is the level of
+    // detail to draw (the coarsest available one is used if the object has less levels). If shaded, the surfaces are
+    // drawn instead of the wireframe of objects that have one. Must be called after upload()
+    void updateVisibleRanges(const QBitArray& drawnObjects, const QVector<quint8>& objectLevels, bool shaded);
+    // Surfaces are drawn with surfaceProgram, which has a "color" uniform. Adds the number of draw calls and indices
+    // drawn to the counters
+    void draw(DisplayManager* displayManager, QOpenGLShaderProgram* surfaceProgram, int& drawCalls, int& indicesDrawn);
+    // Draws the full detail level of the drawn objects, each in the color 0xRRGGBB = object id + 1 so that 0 is left
+    // for the background. Lines and points are drawn at least lineWidth wide. Must be called after upload()
+    void drawObjectIds(const QBitArray& drawnObjects, float lineWidth, bool shaded);
+
+    int getVertexCount() const;
+    // vertices of all objects in the batch, including the ones not uploaded yet
+    int getObjectVertexCount() const;
+
+private:
+    // index range of a single object in the index buffer
+    struct ObjectRange {
+        int objectId;
+        int level;
+        int lastLevel;  // coarsest level of the object
+        PlotGeometry::DrawRange range;
+    };
+
+    // triangle index range of a single object in the surface index buffer
+    struct SurfaceRange {
+        int objectId;
+        int firstIndex;
+        int indexCount;
+    };
+
+    float color[3];
+    QMap<int, PlotGeometry> objects;
+    int objectVertexCount = 0;
+    bool dirty = true;
+
+    QOpenGLBuffer vertexBuffer;
+    QOpenGLBuffer indexBuffer;
+    int vertexCount = 0;
+
+    QVector<ObjectRange> objectRanges;                  // grouped by primitive and size, then level, then object id
+    QVector<PlotGeometry::DrawRange> visibleRanges;     // adjacent visible object ranges merged
+
+    QOpenGLBuffer surfaceVertexBuffer;
+    QOpenGLBuffer surfaceIndexBuffer;
+    QVector<SurfaceRange> surfaceRanges;                // ordered by object id
+    QVector<SurfaceRange> visibleSurfaceRanges;         // adjacent visible object ranges merged, objectId unused
+    // objects with a surface, indexed by object id
+    QBitArray surfaceObjects;
+
+    bool hasSurface(int objectId) const;
+};
+
+#endif //RT3_GEOMETRYBATCH_H
@@ -0,0 +1,108 @@
+/*                     G E O M E T R Y P L O T T E R . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file GeometryPlotter.h */
+
+#ifndef RT3_GEOMETRYPLOTTER_H
+#define RT3_GEOMETRYPLOTTER_H
+
+#include <QObject>
+#include <QHash>
+#include <QMatrix4x4>
+#include <QMutex>
+#include <QThreadPool>
+#include <QVector>
+#include "PlotCache.h"
+#include "PlotGeometry.h"
+
+namespace BRLCAD {
+    class ConstDatabase;
+}
+
+/*
+ * Plots objects on worker threads and converts them to PlotGeometry, so GeometryRenderer only has to upload them.
+ * Results are collected by the GL thread with takeFinished(). objectsReady() is emitted (from a worker thread) when
+ * results become available after the previous takeFinished().
+ *
+ * librt keeps the free list of vector list elements in a global, so the database is only accessed while holding
+ * getDatabaseMutex(). Anything reading or modifying the database while plots may be running has to lock it as well.
+ * This means ConstDatabase::Plot itself runs for one object at a time: the workers keep the GL thread free and
+ * overlap plotting with the cache lookups, the conversion to vertex arrays and the generation of detail levels, but
+ * tessellation does not get faster with more cores. Separate database handles would not help, the free list is
+ * shared by all of them.
+ *
+ * Ids only identify requests, the plotter does not look them up. GeometryRenderer uses negative ids for the shared
+ * geometry of instanced solids.
+ */
+class GeometryPlotter : public QObject {
+    Q_OBJECT
+public:
+    struct Result {
+        int objectId;
+        PlotGeometry geometry;
+        // set by requestTransform, the geometry is empty then
+        bool isTransform = false;
+        QMatrix4x4 transform;
+    };
+
+    explicit GeometryPlotter(BRLCAD::ConstDatabase* database);
+    ~GeometryPlotter() override;
+
+    // queues the object unless it is already being plotted
+    void request(int objectId, const QString& fullPath);
+    // queues computing the product of the combination matrices along fullPath, which places the geometry of the
+    // path's last object (plotted on its own) where the path puts it
+    void requestTransform(int objectId, const QString& fullPath);
+    // a running plot of the object is discarded when it finishes
+    void cancel(int objectId);
+    void cancelAll();
+
+    bool isPending(int objectId) const;
+    int getPendingCount() const;
+    bool hasFinished() const;
+    QVector<Result> takeFinished(int maxCount);
+
+    QMutex* getDatabaseMutex();
+    // objects found in the cache are not plotted, plotted objects are added to it. Set before requesting any plot
+    void setCache(PlotCache* cache);
+
+signals:
+    void objectsReady();
+
+private:
+    friend class PlotTask;
+
+    BRLCAD::ConstDatabase* database;
+    PlotCache* cache = nullptr;
+    QThreadPool threadPool;
+    QMutex databaseMutex;
+
+    // guards everything below
+    mutable QMutex mutex;
+    QHash<int, quint64> pendingGenerations;    // generation of the latest request of each pending object
+    quint64 nextGeneration = 1;
+    QVector<Result> finished;
+
+    quint64 startRequest(int objectId);
+    void plot(int objectId, const QString& fullPath, quint64 generation);
+    void computeTransform(int objectId, const QString& fullPath, quint64 generation);
+    void finish(Result&& result, quint64 generation);
+};
+
+#endif //RT3_GEOMETRYPLOTTER_H
@@ -22,32 +22,174 @@
 #ifndef BRLCAD_GEOMETRYRENDERER_H
 #define BRLCAD_GEOMETRYRENDERER_H
 
+#include <QBitArray>
+#include "BoundingVolumeHierarchy.h"
 #include "DisplayManager.h"
+#include "GeometryBatch.h"
+#include "GeometryPlotter.h"
+#include "InstancedGeometry.h"
+#include "PlotCache.h"
 #include "Renderer.h"
 
+class Display;
+
+/*
+ * GPU buffers of the document's geometry are created once and drawn by every Display of the document. This relies on
+ * all OpenGL contexts sharing with QOpenGLContext::globalShareContext() (Qt::AA_ShareOpenGLContexts). An offscreen
+ * context has to be created with setShareContext(QOpenGLContext::globalShareContext()) to render the geometry.
+ *
+ * Objects are plotted by GeometryPlotter on worker threads. Each frame, finished objects are added to the batches until
+ * uploadTimeBudgetMs is spent, so the displays stay responsive and fill in while a big model is being plotted.
+ * Objects whose record and path matrices did not change are taken from the PlotCache, and the cache is written when
+ * the document is closed.
+ *
+ * Only objects whose bounding box is in the view frustum of the display's camera are drawn. The boxes are kept in a
+ * BoundingVolumeHierarchy, so culling does not test every object. Each display draws every object at the level of
+ * detail (see PlotGeometry::generateLevels) that suits its size on that display.
+ *
+ * Solids that are used by at least instancingThreshold objects are plotted once in their own coordinates and drawn as
+ * InstancedGeometry, with the combination matrices along each object's path as instance transform. Other objects are
+ * plotted with their path and merged into the batches.
+ *
+ * Displays with shadedModeEnabled draw the surfaces of objects that have one with a Phong shader in the object's
+ * color, and the wireframe of the others.
+ *
+ * renderObjectIds draws the same objects with their ids as colors, for ObjectPicker.
+ */
 class GeometryRenderer:public Renderer {
 public:
 
     explicit GeometryRenderer(Document* document);
+    ~GeometryRenderer() override;
 
-    // this is called by Display to render a single frame
+    // this is called by Display to render a single frame into its current context
     void render() override;
+    void render(Display* display);
+    // draws the objects in view of the display at full detail, each one in the color encoding its id
+    void renderObjectIds(Display* display, float lineWidth);
     void refreshForVisibilityAndSolidChanges();
     void clearSolidIfAvailable(int objectId);
     void clearObject(int objectId);
 
+    GeometryPlotter* getPlotter() const
+    {
+        return plotter;
+    }
+
+    // counts of the last rendered frame. Culled objects are visible and plotted but outside of the view frustum
+    int getDrawnObjectCount() const
+    {
+        return drawnObjectCount;
+    }
+
+    int getCulledObjectCount() const
+    {
+        return culledObjectCount;
+    }
+
+    int getDrawCallCount() const
+    {
+        return drawCallCount;
+    }
+
+    // indices drawn, ie. vertices sent through the pipeline
+    int getSubmittedVertexCount() const
+    {
+        return submittedVertexCount;
+    }
+
+    // changes whenever the drawn geometry or the visible objects change
+    quint64 getRevision() const
+    {
+        return revision;
+    }
+
+    // all visible objects are plotted and drawable. Until then, each render adds the objects that finished plotting
+    bool isComplete() const
+    {
+        return objectsToBeDisplayedIds.isEmpty() && plotter->getPendingCount() == 0;
+    }
+
+    // nullptr if the document has no file
+    PlotCache* getPlotCache() const
+    {
+        return plotCache;
+    }
+
 private:
     Document* document;
+    GeometryPlotter* plotter;
+    PlotCache* plotCache = nullptr;
     float defaultWireColor[3] = {1.0,.1,.4};
+    // shared by all contexts, like the batches. nullptr if they failed to compile
+    QOpenGLShaderProgram* surfaceProgram = nullptr;
+    QOpenGLShaderProgram* instancedWireProgram = nullptr;
+    QOpenGLShaderProgram* instancedSurfaceProgram = nullptr;
+    bool programsCreated = false;
+    // time spent on adding plotted objects to batches in a single frame
+    int uploadTimeBudgetMs = 8;
+    // a batch is not extended beyond this, so adding an object re-uploads a bounded amount of data
+    const int maxBatchVertexCount = 1 << 20;
 
 
-    void drawSolid(int objectId);
+    void objectColor(int objectId, float color[3]) const;
+    void addPlottedGeometry(int objectId, const PlotGeometry& geometry);
+    void removePlottedGeometry(int objectId);
+    void updateBoundingVolumeHierarchy();
+    void createPrograms();
+    void updateSolidUseCounts();
+    bool isInstanced(int objectId) const;
+    int solidIndex(const QString& solidName);
+    // plot id of the shared geometry of a solid, negative so it does not collide with object ids
+    static int solidPlotId(int solidIndex)
+    {
+        return -1 - solidIndex;
+    }
+    void setSolidGeometry(int solidIndex, const PlotGeometry& geometry);
+    void addInstance(int objectId, const QMatrix4x4& transform);
+    void updateInstanceBounds(int objectId, const InstancedGeometry* solid);
+    QBitArray objectsInView(const Display* display);
+    const QVector<quint8>& updateLevelsOfDetail(const Display* display, const QBitArray& drawnObjects);
+    quint32 batchKey(const float color[3]) const;
 
-    // Contains generated display list alone with corresponding objectId. objectId is the key. displayListId is value.
-    QHash<int, int>             objectIdDisplayListIdMap;
+    // Plotted objects grouped by color. Key is the color packed as 0xRRGGBB
+    QHash<quint32, QVector<GeometryBatch*>> colorBatches;
+    // Batch of each plotted object. objectId is the key.
+    QHash<int, GeometryBatch*>      objectIdBatchMap;
 
-    QVector<int> visibleDisplayListIds;
+    const int instancingThreshold = 4;
+    // number of drawable objects using each solid, by name. Counted again when the number of drawable objects changes
+    QHash<QString, int> solidUseCounts;
+    int solidUseCountsObjectCount = -1;
+    // instanced solids by index, solidIndices maps their names to it
+    QHash<QString, int> solidIndices;
+    QVector<QString> solidNames;
+    QHash<int, InstancedGeometry*> instancedSolids;
+    // solid index of each instance. objectId is the key
+    QHash<int, int> objectIdSolidMap;
+
+    // indexed by object id
+    QBitArray visibleObjects;
+    QBitArray plottedObjects;
     QVector<int> objectsToBeDisplayedIds;
+
+    // model space bounds of plotted objects. objectId is the key
+    QHash<int, AxisAlignedBox>  objectBounds;
+    BoundingVolumeHierarchy     boundingVolumeHierarchy;
+    bool boundingVolumeHierarchyDirty = false;
+    // plotted after the hierarchy was built
+    QVector<int> unindexedObjectIds;
+
+    // level of detail of each object (indexed by object id) on each display
+    QHash<const Display*, QVector<quint8>> displayObjectLevels;
+    // fraction of the size limit an object has to cross before its level changes
+    const float levelHysteresis = .2f;
+
+    quint64 revision = 0;
+    int drawnObjectCount = 0;
+    int culledObjectCount = 0;
+    int drawCallCount = 0;
+    int submittedVertexCount = 0;
 };
 
 
@@ -7,16 +7,30 @@
 #include "Display.h"
 
 class Display;
+class QOpenGLShaderProgram;
 
+/*
+ * Draws the XY plane grid as a single screen covering quad. The lines are computed in the fragment shader, with
+ * anti-aliasing based on the screen space derivatives of the plane coordinates. Spacing is a power of 10 picked from
+ * the zoom level; the finer level fades out as it gets too dense, so zooming changes the grid smoothly.
+ */
 class GridRenderer: public Renderer {
 
 public:
     void render() override;
 
     GridRenderer(Display *display);
+    ~GridRenderer() override;
 
 private:
     Display * display;
+    QOpenGLShaderProgram * program = nullptr;
+    bool programFailed = false;
+
+    // minimum distance of the finest drawn lines in pixels
+    const float minimumLineSpacing = 8.f;
+
+    bool createProgram();
 };
 
 
@@ -0,0 +1,107 @@
+/*                I N S T A N C E D G E O M E T R Y . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file InstancedGeometry.h */
+
+#ifndef RT3_INSTANCEDGEOMETRY_H
+#define RT3_INSTANCEDGEOMETRY_H
+
+#include <QBitArray>
+#include <QMap>
+#include <QMatrix4x4>
+#include <QOpenGLBuffer>
+#include <QOpenGLShaderProgram>
+#include "PlotGeometry.h"
+
+class DisplayManager;
+
+/*
+ * The geometry of a solid that many objects refer to under different combination matrices. It is plotted once in the
+ * solid's own coordinates and uploaded once, each object using it is an instance with its own transform and color.
+ * Instances at the same level of detail are drawn with one instanced draw call per range, so buffer memory and draw
+ * calls depend on the unique geometry rather than on the number of instances.
+ *
+ * Instanced draw calls need OpenGL 3.3 (ES 3.0). Otherwise each instance is drawn on its own, with its transform
+ * multiplied onto the model view matrix.
+ */
+class InstancedGeometry {
+public:
+    // programs used by draw(), nullptr where they could not be created
+    struct Programs {
+        QOpenGLShaderProgram* surface;              // "color" uniform
+        QOpenGLShaderProgram* instancedWire;        // "instanceMatrix" and "instanceColor" attributes
+        QOpenGLShaderProgram* instancedSurface;     // "instanceMatrix" and "instanceColor" attributes
+    };
+
+    InstancedGeometry();
+
+    // instances can be added before the geometry is plotted, they are drawn once it is set
+    bool hasGeometry() const;
+    const PlotGeometry& getGeometry() const;
+    void setGeometry(const PlotGeometry& geometry);
+
+    void addInstance(int objectId, const QMatrix4x4& transform, const float color[3]);
+    void removeInstance(int objectId);
+    const QMatrix4x4& getTransform(int objectId) const;
+    QList<int> getInstanceIds() const;
+
+    // buffers are created in the current context and shared like the ones of GeometryBatch
+    void upload();
+    void destroyBuffers();
+
+    // objectLevels is the level of detail of each object (indexed by object id). In shaded mode the surface is drawn
+    // instead of the wireframe if there is one. Adds the number of draw calls and indices drawn to the counters
+    void draw(DisplayManager* displayManager, const Programs& programs, const QBitArray& drawnObjects,
+              const QVector<quint8>& objectLevels, bool shaded, int& drawCalls, int& indicesDrawn);
+    // same as GeometryBatch::drawObjectIds
+    void drawObjectIds(const QBitArray& drawnObjects, float lineWidth, bool shaded);
+
+private:
+    struct Instance {
+        QMatrix4x4 transform;
+        float color[3];
+    };
+
+    // per instance data in instanceBuffer: the column-major transform, then the color
+    static const int instanceFloatCount = 19;
+
+    PlotGeometry geometry;
+    bool geometrySet = false;
+    bool dirty = true;
+    QMap<int, Instance> instances;
+
+    QOpenGLBuffer vertexBuffer;
+    QOpenGLBuffer indexBuffer;
+    QOpenGLBuffer surfaceVertexBuffer;
+    QOpenGLBuffer surfaceIndexBuffer;
+    QOpenGLBuffer instanceBuffer;
+
+    static bool instancingSupported();
+    void drawInstanced(const Programs& programs, const QVector<int>& surfaceInstances,
+                       const QVector<QVector<int>>& levelInstances, int& drawCalls, int& indicesDrawn);
+    void drawEach(DisplayManager* displayManager, const Programs& programs, const QVector<int>& surfaceInstances,
+                  const QVector<QVector<int>>& levelInstances, int& drawCalls, int& indicesDrawn);
+    void bindSurface(bool withNormals);
+    void releaseSurface(bool withNormals);
+    void bindWire();
+    void releaseWire();
+    void setInstanceAttributes(QOpenGLShaderProgram* program, int firstInstance, bool enable);
+};
+
+#endif //RT3_INSTANCEDGEOMETRY_H
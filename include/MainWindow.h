@@ -47,6 +47,9 @@ public:
 
     const int statusBarShortMessageDuration = 7000;
 
+    // sets Globals::theme and the application style sheet. Also used by CommandLine, which has no main window
+    static void loadTheme();
+
 private:
 	// UI components
     Dockable *objectTreeWidgetDockable;
@@ -74,7 +77,6 @@ private:
     int activeDocumentId = -1;
 	
     void prepareUi();
-    void loadTheme();
     void prepareDockables();
 
     void newFile(); // empty new file
@@ -22,6 +22,7 @@
 #ifndef MOVECAMERAMOUSEACTION_H
 #define MOVECAMERAMOUSEACTION_H
 
+#include <QPoint>
 #include "MouseAction.h"
 
 
@@ -38,9 +39,15 @@ private:
     int prevMouseX = -1;
     int prevMouseY = -1;
     bool skipNextMouseMoveEvent = false;
+    // a press and release of selectObjectMouseButton without dragging selects the object under the cursor
+    QPoint pressPosition;
+    bool dragged = false;
+
+    void selectObjectAt(const QPoint& position);
 
     Qt::MouseButton rotateCameraMouseButton = Qt::LeftButton;
     Qt::MouseButton moveCameraMouseButton = Qt::RightButton;
+    Qt::MouseButton selectObjectMouseButton = Qt::LeftButton;
     Qt::KeyboardModifier rotateAroundThirdAxisModifier = Qt::ShiftModifier;
 };
 
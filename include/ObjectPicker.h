@@ -0,0 +1,63 @@
+/*                     O B J E C T P I C K E R . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file ObjectPicker.h */
+
+#ifndef RT3_OBJECTPICKER_H
+#define RT3_OBJECTPICKER_H
+
+#include <QMatrix4x4>
+
+class Display;
+class QOpenGLFramebufferObject;
+
+/*
+ * Finds the object under a point of a Display. The objects in view are drawn into an offscreen framebuffer with their
+ * id as color (see GeometryBatch::drawObjectIds), so a pick reads back a single pixel instead of testing the objects.
+ *
+ * The id buffer is rendered on the first pick after the camera, the size of the display, its shading mode or the
+ * drawn geometry changed, and reused until then. Navigating the view costs nothing until the next click.
+ */
+class ObjectPicker {
+public:
+    explicit ObjectPicker(Display* display);
+    // must be deleted with the display's context current
+    ~ObjectPicker();
+
+    // object id at widget coordinates x, y, -1 if there is no object. Makes the display's context current
+    int pick(int x, int y);
+
+private:
+    Display* display;
+    QOpenGLFramebufferObject* framebuffer = nullptr;
+
+    // what the id buffer was rendered with
+    QMatrix4x4 modelViewMatrix;
+    QMatrix4x4 projectionMatrix;
+    quint64 geometryRevision = 0;
+    bool shaded = false;
+
+    // lines are widened in the id buffer so they can be hit without pixel precision
+    const float pickLineWidth = 5.f;
+
+    bool isUpToDate() const;
+    void render();
+};
+
+#endif //RT3_OBJECTPICKER_H
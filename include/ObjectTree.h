@@ -6,6 +6,9 @@
 #include <QHash>
 #include <QSet>
 #include <QVector>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
 #include "brlcad/MemoryDatabase.h"
 #include <brlcad/Combination.h>
 #include <functional>
@@ -35,14 +38,86 @@ public:
         FullyVisible,
     };
 
-    ObjectTree(BRLCAD::MemoryDatabase* database);
+    // Per object metadata captured while the tree is built, so we never have to go back to the database for it
+    struct ObjectInfo {
+        quint16 typeIndex = 0;  // index into objectTypes
+        bool isRegion = false;
+        int regionId = 0;
+    };
+
+    // if filePath is given, the tree is loaded from ObjectTreeCache when the file hasn't changed since last time
+    ObjectTree(BRLCAD::MemoryDatabase* database, const QString* filePath = nullptr);
 
     int lastAllocatedId = 0;
 
     void traverseSubTree(int rootOfSubTreeId, bool traverseRoot, const std::function<bool(int)>&);
 
+    /*
+     * Visits the sub tree of rootOfSubTreeId in pre-order. visitor(int objectId) is called for each object and
+     * the children of an object are visited only if visitor returns true (the return value for the root is ignored).
+     * This is iterative (an explicit stack instead of recursion) and the visitor is inlined, so prefer this over
+     * traverseSubTree in hot paths.
+     */
+    template<typename Visitor>
+    void traverse(int rootOfSubTreeId, bool traverseRoot, Visitor&& visitor) const
+    {
+        if (traverseRoot) visitor(rootOfSubTreeId);
+
+        QVector<int> stack;
+        pushChildren(stack, rootOfSubTreeId);
+        traverseStack(stack, visitor);
+    }
+
+    /*
+     * Same as traverse, but independent sub trees are visited concurrently on the global thread pool.
+     * visitor must be safe to call from several threads at once (ie. only read the tree) and the order of visits
+     * between sub trees is not defined. Returns after all objects have been visited.
+     */
+    template<typename Visitor>
+    void parallelTraverse(int rootOfSubTreeId, bool traverseRoot, const Visitor& visitor) const
+    {
+        if (traverseRoot) visitor(rootOfSubTreeId);
+
+        // Open up the top of the tree on this thread until there are enough independent sub trees.
+        // Every object in frontier is not yet visited.
+        QThreadPool* pool = QThreadPool::globalInstance();
+        const int wantedTaskCount = qMax(1, pool->maxThreadCount()) * 4;
+        QVector<int> frontier = objectIdChildrenObjectIdsMap[rootOfSubTreeId];
+        bool expanded = true;
+        while (expanded && frontier.size() < wantedTaskCount) {
+            expanded = false;
+            QVector<int> nextFrontier;
+            for (int objectId : frontier) {
+                const QVector<int>& children = objectIdChildrenObjectIdsMap[objectId];
+                if (children.isEmpty()) {
+                    nextFrontier.append(objectId);
+                    continue;
+                }
+                expanded = true;
+                if (visitor(objectId)) nextFrontier.append(children);
+            }
+            frontier = nextFrontier;
+        }
+
+        if (frontier.size() <= 1 || pool->maxThreadCount() <= 1) {
+            QVector<int> stack;
+            for (int i = frontier.size() - 1; i >= 0; i--) stack.append(frontier[i]);
+            traverseStack(stack, visitor);
+            return;
+        }
+
+        const int taskCount = qMin(wantedTaskCount, frontier.size());
+        QSemaphore done;
+        for (int task = 0; task < taskCount; task++) {
+            QVector<int> stack;
+            for (int i = frontier.size() - 1 - task; i >= 0; i -= taskCount) stack.append(frontier[i]);
+            pool->start(new TraversalTask<Visitor>(this, stack, visitor, done));
+        }
+        done.acquire(taskCount);
+    }
+
     void changeVisibilityState(int objectId, bool visible);
-    void buildColorMap(int rootObjectId);
+    // reads the object from the database, use Document::addTopObject once the document exists
     int addTopObject(QString name);
 
         // getters
@@ -51,7 +126,8 @@ public:
 	    return database;
     }
 
-    QHash<int, QVector<int>>& getChildren()
+    // indexed by object id
+    QVector<QVector<int>>& getChildren()
     {
         return objectIdChildrenObjectIdsMap;
     }
@@ -71,11 +147,22 @@ public:
         return fullPathMap;
     }
 	
-    QHash<int, ColorInfo>& getColorMap()
+    // indexed by object id
+    QVector<ColorInfo>& getColorMap()
     {
         return colorMap;
     }
 
+    const ObjectInfo& getObjectInfo(int objectId) const
+    {
+        return objectInfo[objectId];
+    }
+
+    const QString& getObjectType(int objectId) const
+    {
+        return objectTypes[objectInfo[objectId].typeIndex];
+    }
+
     QSet<int>& getDrawableObjectIds()
     {
         return drawableObjectIds;
@@ -86,6 +173,8 @@ public:
     }
 	
 private:
+    friend class ObjectTreeCache;
+
     BRLCAD::MemoryDatabase* database;
 	
 	// this class is used for traversing the MemoryDatabase and produce the tree
@@ -107,8 +196,8 @@ private:
         void traverseSubTree(const BRLCAD::Combination::ConstTreeNode& node) const; //traverse the boolean tree of the MemoryDatabase
     };
 
-    // Stores the object tree in  {parent's object id (key), children's object ids (value)} format
-    QHash<int, QVector<int>>    objectIdChildrenObjectIdsMap;
+    // Stores the object tree in  {parent's object id (index), children's object ids (value)} format
+    QVector<QVector<int>>       objectIdChildrenObjectIdsMap;
 
     // Stores the object tree in  { object id (key), parent's object id (value)} format
     QHash<int, int>    objectIdParentObjectIdMap;
@@ -119,14 +208,60 @@ private:
     // Object id to it's full path mapping
     QHash<int, QString>         fullPathMap;
 
-    // Object id to it's full path mapping
-    QHash<int, ColorInfo>         colorMap;
+    // Object id to it's color mapping. Colors are inherited from parent combinations. Indexed by object id
+    QVector<ColorInfo>          colorMap;
+
+    // Object id to it's type and region information. Indexed by object id
+    QVector<ObjectInfo>         objectInfo;
+
+    // Type names (ie. "Combination", "Torus") referred by ObjectInfo::typeIndex
+    QVector<QString>            objectTypes;
+    QHash<QString, quint16>     objectTypeIndices;
 
     // Get all objects that are not combinations. (ie. these are also the objects that can be drawn) //todo _GLOBAL?
     QSet<int>                   drawableObjectIds;
 
 
     QHash<int, VisibilityState>             objectIdVisibilityStateMap;
+
+    void build();
+    void reserveObjectId(int objectId);
+    quint16 objectTypeIndex(const char* type);
+
+    void pushChildren(QVector<int>& stack, int objectId) const
+    {
+        const QVector<int>& children = objectIdChildrenObjectIdsMap[objectId];
+        for (int i = children.size() - 1; i >= 0; i--) stack.append(children[i]);
+    }
+
+    // visits everything on the stack (top first) and their sub trees
+    template<typename Visitor>
+    void traverseStack(QVector<int>& stack, Visitor& visitor) const
+    {
+        while (!stack.isEmpty()) {
+            const int objectId = stack.takeLast();
+            if (visitor(objectId)) pushChildren(stack, objectId);
+        }
+    }
+
+    template<typename Visitor>
+    class TraversalTask : public QRunnable {
+    public:
+        TraversalTask(const ObjectTree* objectTree, const QVector<int>& stack, const Visitor& visitor, QSemaphore& done) :
+            objectTree(objectTree), stack(stack), visitor(visitor), done(done) {}
+
+        void run() override
+        {
+            objectTree->traverseStack(stack, visitor);
+            done.release();
+        }
+
+    private:
+        const ObjectTree* objectTree;
+        QVector<int> stack;
+        const Visitor& visitor;
+        QSemaphore& done;
+    };
 };
 
 #endif
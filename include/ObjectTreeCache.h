@@ -0,0 +1,60 @@
+/*                  O B J E C T T R E E C A C H E . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file ObjectTreeCache.h */
+
+#ifndef RT3_OBJECTTREECACHE_H
+#define RT3_OBJECTTREECACHE_H
+
+#include <QString>
+
+class ObjectTree;
+
+/*
+ * Binary sidecar cache of an ObjectTree, stored in the BRL-CAD cache folder next to the .atr files.
+ * The cache file lives in a folder named after the content hash (UUID) of the .g file, in the same way as
+ * VerificationValidationWidget stores its databases, and the hash is stored in the file as well.
+ * So a cache file is only ever used for the exact .g file content it was created from.
+ *
+ * Loading memory maps the cache file and fills the ObjectTree without touching the BRL-CAD database.
+ */
+class ObjectTreeCache {
+public:
+    explicit ObjectTreeCache(const QString& gFilePath);
+
+    // false if the .g file could not be hashed. load and save do nothing in that case
+    bool isValid() const
+    {
+        return !uuid.isEmpty();
+    }
+
+    const QString& getCacheFilePath() const
+    {
+        return cacheFilePath;
+    }
+
+    bool load(ObjectTree* objectTree) const;
+    bool save(const ObjectTree* objectTree) const;
+
+private:
+    QString uuid;
+    QString cacheFilePath;
+};
+
+#endif //RT3_OBJECTTREECACHE_H
@@ -36,7 +36,9 @@
 #include <QApplication>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QLineEdit>
 #include <bu.h>
+#include "TrigramIndex.h"
 class Document;
 class ObjectTreeWidget : public QTreeWidget {
     Q_OBJECT
@@ -44,16 +46,34 @@ public:
     explicit ObjectTreeWidget(Document *objectTree,   QWidget *parent = nullptr);
     void refreshItemTextColors();
     const QHash<int, QTreeWidgetItem *> &getObjectIdTreeWidgetItemMap() const;
+    // adds the items of objectId's sub tree, and filters them like the others
     void build(int objectId, QTreeWidgetItem* parent = nullptr);
 
     enum Name { PATHNAME, BASENAME };
     enum Level { TOP, ALL };
     QStringList getSelectedObjects(const Name& name, const Level& level);
-    
+    // makes the object the current item, expanding its ancestors. Emits selectionChanged
+    void selectObject(int objectId);
+
+    // Shows only the objects whose name (or full path if filter contains a '/') contains filter, with their
+    // ancestors and descendants. An empty filter shows every object again.
+    void setFilter(const QString& filter);
+
+protected:
+    void resizeEvent(QResizeEvent* event) override;
+
 private:
     Document* document;
     QHash <int, QTreeWidgetItem*> objectIdTreeWidgetItemMap;
 
+    // filter box sits above the tree, in the space left by the viewport margins
+    QLineEdit* filterBox;
+    TrigramIndex nameIndex;
+    TrigramIndex fullPathIndex;
+    QSet<int> filterHiddenObjectIds;
+    void buildFilterIndices();
+    void buildItems(int objectId, QTreeWidgetItem* parent);
+
     QColor colorFullVisible;
     QColor colorSomeChildrenVisible;
     QColor colorInvisible;
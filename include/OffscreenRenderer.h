@@ -0,0 +1,78 @@
+/*                O F F S C R E E N R E N D E R E R . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file OffscreenRenderer.h */
+
+#ifndef RT3_OFFSCREENRENDERER_H
+#define RT3_OFFSCREENRENDERER_H
+
+#include <QImage>
+
+class Display;
+class Document;
+class QOffscreenSurface;
+class QOpenGLContext;
+class QOpenGLFramebufferObject;
+
+/*
+ * Renders a view of a document into a framebuffer object, without a window. The context is made on a
+ * QOffscreenSurface and shares with QOpenGLContext::globalShareContext(), so the document's GeometryRenderer draws
+ * with the same buffers and programs as its displays.
+ *
+ * The view is a Display that is never shown. It holds the camera and the render settings (shadedModeEnabled,
+ * gridEnabled, axesEnabled), and its drawScene() is what a visible display draws in paintGL.
+ *
+ * Machines without a GPU can render with a software OpenGL implementation, see CommandLine.
+ */
+class OffscreenRenderer {
+public:
+    OffscreenRenderer(Document* document, int w, int h);
+    virtual ~OffscreenRenderer();
+
+    // false if no OpenGL context could be created
+    bool isValid() const;
+    Display* getView() const;
+    int getW() const;
+    int getH() const;
+    void resize(int w, int h);
+
+    // draws one frame. Objects that finished plotting since the previous frame are added to the geometry
+    void renderFrame();
+    // renders frames until all visible objects are plotted, false if that took longer than timeoutMs
+    bool renderUntilComplete(int timeoutMs);
+    // waits until the GPU executed all frames rendered so far
+    void finish();
+    QImage grabImage();
+
+    // GL_RENDERER of the context, tells which implementation a benchmark ran on
+    QString getRendererName();
+
+private:
+    Document* document;
+    Display* view;
+    QOffscreenSurface* surface;
+    QOpenGLContext* context;
+    QOpenGLFramebufferObject* framebuffer = nullptr;
+    const int samples = 4;
+
+    bool makeCurrent();
+    void createFramebuffer();
+};
+
+#endif //RT3_OFFSCREENRENDERER_H
@@ -0,0 +1,119 @@
+/*                        P L O T C A C H E . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file PlotCache.h */
+
+#ifndef RT3_PLOTCACHE_H
+#define RT3_PLOTCACHE_H
+
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include "PlotGeometry.h"
+
+struct db_i;
+
+/*
+ * Binary cache of the PlotGeometry of plotted objects of a .g file, stored in the BRL-CAD cache folder like
+ * ObjectTreeCache, one cache file per .g file path.
+ *
+ * Entries are keyed by what the geometry was plotted from: the database record of the path's last object (hashed as
+ * it is stored in the .g file) and the matrices along the path. Editing and saving the file only invalidates the
+ * entries of the objects that changed, everything else is found again under the same key. Objects that were changed
+ * in memory but are not saved yet get no key, their records in the .g file are out of date.
+ *
+ * load() memory maps the cache file, find() copies an entry out of the mapping after checking that its indices and
+ * ranges are inside its arrays. Newly plotted objects are added with insert() and written together with the mapped
+ * ones by save(). Entries that were not used for maxUnusedSaves saves are dropped. All methods except load and save
+ * may be called from any thread, load and save must not run while other methods are in use.
+ */
+class PlotCache {
+public:
+    explicit PlotCache(const QString& gFilePath);
+    ~PlotCache();
+
+    bool isValid() const
+    {
+        return !cacheFilePath.isEmpty();
+    }
+
+    const QString& getCacheFilePath() const
+    {
+        return cacheFilePath;
+    }
+
+    bool load();
+    bool save();
+
+    // Key of the geometry ConstDatabase::Plot draws for a path ending in objectName, with pathMatrices the leaf
+    // matrices along the path (see GeometryPlotter). Empty if objectName is not in the .g file or was changed since
+    // the file was saved, such an object is not cached
+    QByteArray objectKey(const QString& objectName, const QByteArray& pathMatrices);
+    bool find(const QByteArray& key, PlotGeometry& geometry);
+    // objectName is the object the key was made for. Ignored if it changed since
+    void insert(const QByteArray& key, const QString& objectName, const PlotGeometry& geometry);
+
+    // the object in memory differs from the .g file now. Call before changing it in the database
+    void objectModified(const QString& objectName);
+    // the database was saved to gFilePath, records are hashed from there again. Call while no object is being plotted,
+    // that is with GeometryPlotter's database mutex held
+    void fileSaved(const QString& gFilePath);
+
+private:
+    struct MappedEntry {
+        quint32 vertexCount;
+        quint32 indexCount;
+        quint32 rangeCount;
+        quint32 surfaceVertexCount;
+        quint32 surfaceIndexCount;
+        quint32 lastUsedSave;
+        const uchar* data;
+    };
+
+    static const quint32 maxUnusedSaves = 8;
+
+    QString cacheFilePath;
+
+    QFile mappedFile;
+    uchar* mappedData = nullptr;
+    quint32 saveCount = 0;
+
+    // guards everything below
+    mutable QMutex mutex;
+    QHash<QByteArray, MappedEntry> mappedEntries;
+    QHash<QByteArray, PlotGeometry> insertedEntries;
+    QSet<QByteArray> usedKeys;
+    bool dirty = false;
+
+    // guards the .g file's records and their hashes
+    QMutex recordMutex;
+    QString gFilePath;
+    db_i* recordDatabase = nullptr;
+    QHash<QString, QByteArray> recordHashes;
+    QSet<QString> modifiedObjectNames;
+
+    void unmap();
+    void openRecordDatabase();
+    void closeRecordDatabase();
+    QByteArray recordHash(const QString& objectName);
+};
+
+#endif //RT3_PLOTCACHE_H
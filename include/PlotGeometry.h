@@ -0,0 +1,107 @@
+/*                     P L O T G E O M E T R Y . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file PlotGeometry.h */
+
+#ifndef RT3_PLOTGEOMETRY_H
+#define RT3_PLOTGEOMETRY_H
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+#include <GL/gl.h>
+#include <QVector>
+#include "AxisAlignedBox.h"
+#include "VectorList.h"
+
+/*
+ * The wireframe of one object, converted from a BRLCAD::VectorList into arrays that can be copied to vertex and
+ * index buffers as they are. Line strips of the vector list become GL_LINES index pairs so any number of objects can
+ * be drawn with a single glDrawElements.
+ *
+ * Polygons and triangles are converted to their outlines. Display space elements (text etc.) are not supported.
+ * They are also kept as an indexed triangle mesh with normals (the surface), which is drawn in shaded mode. Objects
+ * whose plot has no polygons have no surface and are drawn as wireframe in shaded mode too.
+ *
+ * Besides the plotted wireframe (level 0) there can be coarser levels of detail made by generateLevels(). They reuse
+ * the vertices and only add indices, which are appended after the indices of level 0.
+ */
+class PlotGeometry {
+public:
+    // a run of indices drawn with the same primitive and line width / point size (0 means the current GL state)
+    struct DrawRange {
+        GLenum mode;
+        float size;
+        int firstIndex;
+        int indexCount;
+    };
+
+    static const int maxLevelCount = 4;
+
+    QVector<GLfloat> vertices;  // x y z, interleaved
+    QVector<GLuint> indices;
+    QVector<DrawRange> ranges;  // level 0
+    QVector<QVector<DrawRange>> coarseLevels;   // ranges of level 1, 2...
+    QVector<GLfloat> surfaceVertices;   // x y z nx ny nz, interleaved
+    QVector<GLuint> surfaceIndices;     // GL_TRIANGLES
+    AxisAlignedBox bounds;
+
+    void updateBounds();
+    // Simplifies the line strips of level 0 with growing tolerances relative to the size of the object. Stops early
+    // if a level would not be noticeably smaller than the previous one
+    void generateLevels();
+
+    // the distance a level may deviate from the plotted wireframe, relative to the diagonal of bounds
+    static float levelTolerance(int level);
+
+    int levelCount() const
+    {
+        return 1 + coarseLevels.size();
+    }
+
+    const QVector<DrawRange>& levelRanges(int level) const
+    {
+        return level == 0 ? ranges : coarseLevels[level - 1];
+    }
+
+    static PlotGeometry fromVectorList(BRLCAD::VectorList& vectorList);
+
+    bool isEmpty() const
+    {
+        return indices.isEmpty() && surfaceIndices.isEmpty();
+    }
+
+    bool hasSurface() const
+    {
+        return !surfaceIndices.isEmpty();
+    }
+
+    int vertexCount() const
+    {
+        return vertices.size() / 3;
+    }
+
+    int surfaceVertexCount() const
+    {
+        return surfaceVertices.size() / 6;
+    }
+};
+
+#endif //RT3_PLOTGEOMETRY_H
@@ -0,0 +1,90 @@
+/*                    R A Y T R A C E B A T C H . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file RaytraceBatch.h */
+
+#ifndef RT3_RAYTRACEBATCH_H
+#define RT3_RAYTRACEBATCH_H
+
+#include <QColor>
+#include <QString>
+#include <QVector>
+#include <QVector3D>
+#include "Raytracer.h"
+
+class Document;
+
+/*
+ * Raytraces the visible objects of a document from a list of views into image files, eg. the standard views for a
+ * report or the frames of a turntable. All views are autoviewed on the same objects, so they show the model at the
+ * same scale.
+ *
+ * The frames are traced one after the other by one Raytracer, each on all cores. Its worker databases select and prep
+ * the objects once for the first frame and keep them for all others. Writing a frame's image file runs in the
+ * background while the next frame is traced.
+ *
+ * The output pattern names the files: {file} is replaced by the document's file name without extension, {view} by
+ * the view's name and {index} by the view's position in the list, zero padded to the same width for all views. The
+ * image format follows the extension, eg. out/{file}_{view}.png.
+ */
+class RaytraceBatch {
+public:
+    struct View {
+        QString name;
+        // degrees, like OrthographicCamera
+        QVector3D anglesAroundAxes;
+    };
+
+    struct Frame {
+        QString viewName;
+        QString filePath;
+        double traceMs = 0.;
+        bool written = false;
+    };
+
+    // the default views of the four displays of DisplayGrid: top, front, side and iso
+    static QVector<View> standardViews();
+    // frameCount views turning around the vertical axis, from the iso view
+    static QVector<View> turntableViews(int frameCount);
+
+    // true if each view gets a file of its own
+    static bool isValidPattern(const QString& outputPattern);
+
+    RaytraceBatch(Document* document, int w, int h);
+
+    void setBackground(const QColor& background);
+    void setAntiAliasingEnabled(bool enabled);
+
+    // traces all views and returns once their files are written
+    QVector<Frame> run(const QVector<View>& views, const QString& outputPattern);
+
+private:
+    Document* document;
+    int w;
+    int h;
+    QColor background = Qt::black;
+    Raytracer raytracer;
+
+    // frames being written at the same time, each holds a full image
+    const int maxPendingWrites = 2;
+
+    QString filePath(const QString& outputPattern, const View& view, int index, int indexWidth) const;
+};
+
+#endif //RT3_RAYTRACEBATCH_H
@@ -0,0 +1,59 @@
+/*                  R A Y T R A C E S H A D I N G . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file RaytraceShading.h */
+
+#ifndef RT3_RAYTRACESHADING_H
+#define RT3_RAYTRACESHADING_H
+
+#include <QColor>
+#include <QVector>
+#include <QVector3D>
+
+/*
+ * What the rays of a tile hit, in struct of arrays layout. Ray intersection only records hits here. shadeHits then
+ * computes the colors of all rays at once, loading the values of several rays into a SIMD register.
+ */
+struct RayHits {
+    QVector<float> normalX;
+    QVector<float> normalY;
+    QVector<float> normalZ;
+    // color of the hit region, 0 to 1
+    QVector<float> red;
+    QVector<float> green;
+    QVector<float> blue;
+    // distance from the ray's origin
+    QVector<float> depth;
+    // hash of the hit region's name, 0 if the ray hit nothing
+    QVector<quint32> region;
+
+    void resize(int count);
+    void set(int index, const QVector3D& normal, float red, float green, float blue, float depth, quint32 region);
+    void setMissed(int index);
+};
+
+/*
+ * Phong shading of the first count hits, for rays along direction (normalized), into colors. Rays that hit nothing
+ * get the background color. Uses AVX2 or SSE2 if the compiler targets them and plain C++ otherwise.
+ */
+void shadeHits(const RayHits& hits, int count, const QVector3D& direction, QRgb background, QRgb* colors);
+// the same in plain C++, which the SIMD paths are checked against (see unit_testing/shading_test.cpp)
+void shadeHitsScalar(const RayHits& hits, int count, const QVector3D& direction, QRgb background, QRgb* colors);
+
+#endif //RT3_RAYTRACESHADING_H
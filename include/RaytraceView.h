@@ -32,10 +32,15 @@
 #define GRAPHICVIEW_H
 
 #include <QWidget>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTreeWidget>
 #include <QMatrix4x4>
 
 #include <brlcad/ConstDatabase.h>
 #include "Document.h"
+#include "Raytracer.h"
+#include "TiledTiffWriter.h"
 
 
 class RaytraceView : public QWidget {
@@ -43,13 +48,20 @@ class RaytraceView : public QWidget {
 public:
     RaytraceView(Document * document,
                  QWidget*               parent = 0);
+    ~RaytraceView() override;
     void raytrace();
+    // raytraces the current viewport as an overlap heat map, and lists the overlapping region pairs
+    void raytraceOverlaps();
+    // traces the current viewport at w x h pixels into a tiled TIFF file, continuing an interrupted raytrace of the
+    // same view into the same file
+    void raytraceToFile(const QString& filePath, int w, int h);
 public slots:
     void Update();
     void UpdateTrafo(const QMatrix4x4& transformation);
 
 protected:
     virtual void paintEvent(QPaintEvent* event);
+    void closeEvent(QCloseEvent* event) override;
 
 private:
     Document* document;
@@ -58,8 +70,29 @@ private:
     QImage                 m_image;
     bool                   m_imageUpTodate;
     bool                   m_updatingImage;
+    Raytracer*             m_raytracer;
+    // full paths of the visible objects
+    QStringList            m_selectedPaths;
+    // signals of older raytraces are ignored
+    quint64                m_raytraceId;
+    QProgressBar*          m_progressBar;
+    QPushButton*           m_cancelButton;
+    QPushButton*           m_saveButton;
+    // the file being written by raytraceToFile, or nullptr
+    TiledTiffWriter*       m_fileWriter;
+    bool                   m_overlapMode;
+    QTreeWidget*           m_overlapList;
+    const int              overlapListWidth = 320;
+    const int              maxOverlapPairs = 100;
 
-    void UpdateImage(void);
+    void startRaytrace();
+    void UpdateImage(int w, int h);
+    void saveImage();
+    void readSettings();
+    QMatrix4x4 viewTransformation(int w, int h) const;
+    quint64 fileSignature(const QMatrix4x4& transformation, int w, int h) const;
+    void fileRaytraceFinished(bool cancelled);
+    QString showOverlapPairs();
 
     QColor color;
 };
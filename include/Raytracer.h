@@ -0,0 +1,236 @@
+/*                        R A Y T R A C E R . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file Raytracer.h */
+
+#ifndef RT3_RAYTRACER_H
+#define RT3_RAYTRACER_H
+
+#include <QAtomicInt>
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QMatrix4x4>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QRect>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QThreadPool>
+#include <QVector>
+#include <QVector3D>
+#include "RaytraceShading.h"
+
+class Document;
+class TiledTiffWriter;
+namespace BRLCAD {
+    class MemoryDatabase;
+}
+
+/*
+ * Raytraces objects of a document on all cores. The image is split into tileSize x tileSize tiles. Worker threads take
+ * the next tile from a shared counter until none is left, so a thread that is done with a cheap (empty) tile goes on
+ * with the next one while others are still busy with expensive ones. Each tile writes packed RGB32 pixels straight
+ * into the image's scan lines. Rays of a tile only record what they hit, the tile is shaded afterwards by shadeHits.
+ *
+ * start() returns immediately, the raytrace runs in the background. A progressive raytrace first shoots one ray per
+ * coarseBlockSize x coarseBlockSize block, so a preview of the whole image is there after a small fraction of the
+ * time, and then traces every pixel. tileFinished() hands a copy of each finished tile to the receiver, and
+ * progressChanged() counts the tiles of the full resolution pass. cancel() stops the workers after their current tile.
+ *
+ * With anti-aliasing enabled, the full resolution pass finds the pixels at edges, where a neighbor shows another
+ * region, a differently oriented surface or a surface at another depth. Only these pixels are supersampled.
+ *
+ * startToFile() traces an image of any size without keeping it in memory: every tile is handed to a TiledTiffWriter as
+ * soon as it is done, and tiles the writer already has from an interrupted run are skipped.
+ *
+ * startOverlaps() is a quick overlap check of the view: each ray reports all of its hits, including overlapping
+ * partitions, and where the segments of two regions intersect by more than overlapTolerance the pixel is colored by
+ * the summed overlap depth, over a dimmed gray image of the model. The overlapping region pairs are collected with
+ * their estimated overlap volume. This only looks at one ray per overlapBlockSize x overlapBlockSize pixels along the
+ * viewing direction, it does not replace gqa's overlap test, but shows where to point it.
+ *
+ * ConstDatabase::ShootRay keeps its ray state (the librt resource and prepped geometry) in the database, so a single
+ * database can not shoot rays from several threads. Each worker has a database of its own instead, loaded from a
+ * snapshot of the document that start writes before it hands the raytrace to the job thread. The worker databases are
+ * loaded by the first raytrace and kept until the document's database changes. A worker only selects its objects again
+ * when the selection signature changed, so its database keeps the geometry librt prepped and a raytrace of the same
+ * objects from another angle starts shooting right away.
+ *
+ * This costs memory and time per worker: there are QThread::idealThreadCount() workers, and each holds the whole
+ * database in memory plus librt's prepped copy of the selected objects. The first raytrace after a change loads and
+ * preps the database once per worker (one load at a time), so it starts later than the following ones.
+ */
+class Raytracer : public QObject {
+    Q_OBJECT
+public:
+    explicit Raytracer(Document* document, QObject* parent = nullptr);
+    ~Raytracer() override;
+
+    // used by the next start
+    void setAntiAliasingEnabled(bool enabled);
+    bool isAntiAliasingEnabled() const
+    {
+        return antiAliasingEnabled;
+    }
+
+    // Starts tracing the objects at selectedPaths (full paths) into a w x h image, after cancelling a running
+    // raytrace. transformation maps image coordinates (x to the right and y up, in pixels) to model coordinates, rays
+    // go along its negative z axis. If the database changed since the last raytrace, a snapshot of it is written
+    // before this returns. Returns the id of the raytrace, which the signals pass on
+    quint64 start(const QMatrix4x4& transformation, int w, int h, const QColor& background,
+                  const QStringList& selectedPaths, bool progressive);
+    // Like start, but traces the writer's image size and writes the tiles to it instead of into an image. The writer
+    // has to be open, with getTileSize() tiles, and has to stay until the raytrace finished. If a tile can not be
+    // written the raytrace ends as cancelled
+    quint64 startToFile(const QMatrix4x4& transformation, const QColor& background, const QStringList& selectedPaths,
+                        TiledTiffWriter* writer);
+    int getTileSize() const
+    {
+        return tileSize;
+    }
+    // Like start, but traces overlaps, see above. getOverlapPairs returns what it found once it finished
+    quint64 startOverlaps(const QMatrix4x4& transformation, int w, int h, const QColor& background,
+                          const QStringList& selectedPaths);
+    // Maps pixels of a w x h image to the model for an orthographic camera at eyePosition, turned by anglesAroundAxes
+    // (degrees, like OrthographicCamera) and showing verticalSpan from the bottom to the top of the image
+    static QMatrix4x4 viewTransformation(const QVector3D& eyePosition, const QVector3D& anglesAroundAxes,
+                                         double verticalSpan, int w, int h);
+    // MD5 of the database snapshot the next raytrace traces, written now if the database changed. Empty if it could
+    // not be written. Call while no raytrace runs
+    QByteArray getSnapshotHash();
+    // returns once the workers stopped
+    void cancel();
+    bool isRunning() const;
+    // traces every pixel and blocks until done
+    QImage render(const QMatrix4x4& transformation, int w, int h, const QColor& background,
+                  const QStringList& selectedPaths);
+
+    struct OverlapPair {
+        QString region1;
+        QString region2;
+        // rays through the overlap
+        int rayCount = 0;
+        // longest overlap along a ray, and the summed overlap depth times the area of a ray
+        double maxDepth = 0.;
+        double volume = 0.;
+    };
+    // of the last overlap raytrace, largest volume first
+    QVector<OverlapPair> getOverlapPairs() const;
+
+signals:
+    // these are emitted from worker threads
+    void tileFinished(quint64 raytraceId, const QRect& rect, const QImage& pixels);
+    void progressChanged(quint64 raytraceId, int finishedTileCount, int tileCount);
+    void finished(quint64 raytraceId, bool cancelled);
+
+private:
+    friend class RaytraceTask;
+    friend class RaytraceJobTask;
+
+    // ray state of a worker thread
+    struct Worker {
+        BRLCAD::MemoryDatabase* database = nullptr;
+        // Document::selectionSignature and the sorted paths of what the database has selected
+        quint64 selectionSignature = 0;
+        QStringList selectedPaths;
+        // of the tile being traced: the first ray of each pixel, and the extra rays of edge pixels
+        RayHits hits;
+        QVector<QRgb> colors;
+        QVector<int> edgePixels;
+        RayHits subSampleHits;
+        QVector<QRgb> subSampleColors;
+        // the tile being traced, when writing to a file
+        QImage tileImage;
+        // what the rays of an overlap raytrace hit: all segments of a ray, the overlap depth of each ray, and the
+        // pairs the worker found so far
+        QVector<QPair<QByteArray, QPair<double, double>>> segments;
+        QVector<float> overlapDepths;
+        QHash<QPair<QByteArray, QByteArray>, OverlapPair> overlapPairs;
+    };
+
+    Document* document;
+    QThreadPool threadPool;
+    // runs the passes of a raytrace, one at a time
+    QThreadPool jobPool;
+    QVector<Worker> workers;
+    // written by startJob, the job and the workers only read the file at snapshotPath
+    quint64 workersDatabaseRevision = 0;
+    QTemporaryDir snapshotDirectory;
+    QString snapshotPath;
+    QByteArray snapshotHash;
+    // librt's directory building is not known to be thread safe, worker databases are loaded one at a time
+    QMutex loadMutex;
+
+    const int tileSize = 32;
+    const int coarseBlockSize = 8;
+    // neighbors are on different sides of an edge if the angle between their normals is over 25 degrees, or their
+    // depths differ by more than edgeDepthPixels pixel widths
+    const float edgeNormalCosine = .9f;
+    const float edgeDepthPixels = 4.f;
+    // overlaps are traced with one ray per block, and counted if they are deeper than the tolerance of the overlaps
+    // test (mm)
+    const int overlapBlockSize = 2;
+    const double overlapTolerance = .3;
+    // the heat map saturates at this overlap depth, in pixel widths
+    const float overlapSaturationPixels = 64.f;
+
+    // the raytrace. Set by start before the job runs
+    quint64 raytraceId = 0;
+    bool progressive = false;
+    bool overlaps = false;
+    bool antiAliasingEnabled = false;
+    bool antiAliasing = false;
+    QAtomicInt cancelled;
+    QImage image;
+    TiledTiffWriter* writer = nullptr;
+    uchar* bits = nullptr;
+    int bytesPerLine = 0;
+    int w = 0;
+    int h = 0;
+    int tilesPerRow = 0;
+    int tileCount = 0;
+    QStringList selectedPaths;          // sorted
+    quint64 selectionSignature = 0;
+    QRgb background = 0;
+    QVector3D origin;       // model coordinates of the top left pixel
+    QVector3D rightStep;    // one pixel to the right
+    QVector3D downStep;     // one pixel down
+    QVector3D direction;
+    float edgeDepth = 0.f;
+
+    // the pass. Set by runPass before the workers start
+    int blockSize = 1;
+    QAtomicInt nextTile;
+    QAtomicInt finishedTileCount;
+
+    void createImage(int w, int h, const QColor& background);
+    quint64 startJob(const QMatrix4x4& transformation, int w, int h, const QColor& background,
+                     const QStringList& selectedPaths);
+    void updateSnapshot();
+    void runJob();
+    void runPass(int blockSize);
+    void work(int workerIndex);
+    bool isEdge(const RayHits& hits, int sample, int neighbor) const;
+    void traceTile(Worker& worker, int tile);
+    void traceOverlapTile(Worker& worker, int tile);
+};
+
+#endif //RT3_RAYTRACER_H
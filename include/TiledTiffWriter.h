@@ -0,0 +1,100 @@
+/*                  T I L E D T I F F W R I T E R . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file TiledTiffWriter.h */
+
+#ifndef RT3_TILEDTIFFWRITER_H
+#define RT3_TILEDTIFFWRITER_H
+
+#include <QBitArray>
+#include <QFile>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+/*
+ * Writes an image of any size tile by tile into an uncompressed, tiled RGB TIFF file (BigTIFF if it exceeds 4 GiB),
+ * so the image never has to be in memory as a whole. Without compression every tile has a fixed place in the file,
+ * and tiles can be written in any order.
+ *
+ * Written tiles are logged in <file>.progress. If the file is opened again for an image with the same size, tile size
+ * and signature (which identifies what is drawn, eg. camera and objects), the tiles in the log are kept, so an
+ * interrupted render continues where it stopped. finish() removes the log.
+ *
+ * isTileWritten and writeTile may be called from any thread.
+ */
+class TiledTiffWriter {
+public:
+    TiledTiffWriter(const QString& filePath, int w, int h, int tileSize, quint64 signature);
+
+    // writes a BigTIFF even if the image fits into a classic TIFF, to check readers with small files. Before open()
+    void forceBigTiff();
+    // tileSize has to be a multiple of 16. Returns false if the file could not be created
+    bool open();
+    // true if open() continued an interrupted file
+    bool isResumed() const
+    {
+        return resumed;
+    }
+    QString getErrorString() const;
+
+    int getWidth() const
+    {
+        return w;
+    }
+    int getHeight() const
+    {
+        return h;
+    }
+
+    int getTileCount() const;
+    int getWrittenTileCount() const;
+    // tiles are numbered row by row, starting at the top left
+    bool isTileWritten(int tile) const;
+    // tileSize x tileSize pixels, the part outside of the image is ignored
+    bool writeTile(int tile, const QImage& pixels);
+    // true once all tiles are written. The progress log is removed then
+    bool finish();
+
+private:
+    QString filePath;
+    int w;
+    int h;
+    int tileSize;
+    quint64 signature;
+    int tilesPerRow;
+    int tileCount;
+    bool bigTiff = false;
+    quint64 firstTileOffset = 0;
+    bool resumed = false;
+
+    // guards everything below
+    mutable QMutex mutex;
+    QFile file;
+    QFile progressFile;
+    QBitArray writtenTiles;
+    int writtenTileCount = 0;
+    QString errorString;
+
+    quint64 tileByteCount() const;
+    QByteArray header() const;
+    bool readProgress();
+};
+
+#endif //RT3_TILEDTIFFWRITER_H
@@ -0,0 +1,61 @@
+/*                     T R I G R A M I N D E X . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file TrigramIndex.h */
+
+#ifndef RT3_TRIGRAMINDEX_H
+#define RT3_TRIGRAMINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/*
+ * Case insensitive substring search over a set of (id, text) pairs.
+ * Every 3 character sequence of a text is mapped to the sorted list of ids containing it. A query is answered by
+ * intersecting the lists of the query's trigrams, and the few remaining candidates are checked with QString::contains.
+ * Queries shorter than 3 characters fall back to a linear scan.
+ *
+ * Ids have to be added in increasing order.
+ */
+class TrigramIndex {
+public:
+    void add(int id, const QString& text);
+    void clear();
+
+    // ids of all texts containing query, in increasing order
+    QVector<int> search(const QString& query) const;
+
+    int size() const
+    {
+        return ids.size();
+    }
+
+private:
+    QVector<int> ids;
+    QVector<QString> texts;     // lower case, parallel to ids
+    QHash<quint64, QVector<int>> postings;     // trigram -> indices into ids, increasing
+
+    static quint64 trigram(const QChar* c)
+    {
+        return (quint64(c[0].unicode()) << 32) | (quint64(c[1].unicode()) << 16) | quint64(c[2].unicode());
+    }
+};
+
+#endif //RT3_TRIGRAMINDEX_H
@@ -109,4 +109,7 @@ QString mgedRun(const QString& cmd, const QString& gFilePath);
 
 QString* generateUUID(const QString& filepath);
 
+// BRL-CAD cache folder used by Arbalest (.atr databases and other sidecar caches)
+QString getCacheFolder();
+
 #endif // UTILS_ARBALEST_H
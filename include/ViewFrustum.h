@@ -0,0 +1,50 @@
+/*                      V I E W F R U S T U M . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file ViewFrustum.h */
+
+#ifndef RT3_VIEWFRUSTUM_H
+#define RT3_VIEWFRUSTUM_H
+
+#include <QMatrix4x4>
+#include <QVector4D>
+#include "AxisAlignedBox.h"
+
+/*
+ * The six planes of the volume a projection * model view matrix maps to the clip cube. Used to find out which objects
+ * can be seen by a camera before drawing them.
+ */
+class ViewFrustum {
+public:
+    enum Intersection {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    explicit ViewFrustum(const QMatrix4x4& viewProjection);
+
+    Intersection intersect(const AxisAlignedBox& box) const;
+
+private:
+    // ax + by + cz + d >= 0 inside
+    QVector4D planes[6];
+};
+
+#endif //RT3_VIEWFRUSTUM_H
@@ -0,0 +1,380 @@
+/*                    C O M M A N D L I N E . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file CommandLine.cpp */
+
+#include <algorithm>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QThread>
+#include <QTextStream>
+#include "CommandLine.h"
+#include "Document.h"
+#include "MainWindow.h"
+#include "OffscreenRenderer.h"
+#include "RaytraceBatch.h"
+
+
+namespace {
+    const char* commandOptions[] = {"--thumbnails", "--benchmark", "--raytrace", "--help-commands"};
+
+    bool hasArgument(const int argc, char* argv[], const char* argument)
+    {
+        for (int i = 1; i < argc; i++) {
+            if (qstrcmp(argv[i], argument) == 0) return true;
+        }
+        return false;
+    }
+
+    bool parseSize(const QString& size, int& w, int& h)
+    {
+        const QStringList parts = size.toLower().split('x');
+        if (parts.size() != 2) return false;
+        bool wOk, hOk;
+        w = parts[0].toInt(&wOk);
+        h = parts[1].toInt(&hOk);
+        return wOk && hOk && w > 0 && h > 0;
+    }
+
+    // the thumbnail of a document that is being plotted
+    struct ThumbnailJob {
+        QString filePath;
+        Document* document;
+        OffscreenRenderer* renderer;
+        QElapsedTimer timer;
+    };
+}
+
+
+bool CommandLine::isRequested(const int argc, char* argv[])
+{
+    for (const char* option : commandOptions) {
+        if (hasArgument(argc, argv, option)) return true;
+    }
+    return false;
+}
+
+void CommandLine::setApplicationAttributes(const int argc, char* argv[])
+{
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MACOS)
+    // the xcb platform aborts without a display server, the documents' widgets are never shown anyway
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM") && qEnvironmentVariableIsEmpty("DISPLAY") &&
+        qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+#endif
+
+    if (!hasArgument(argc, argv, "--software-gl")) return;
+    // Qt loads opengl32sw on Windows, Mesa picks llvmpipe elsewhere
+    QCoreApplication::setAttribute(Qt::AA_UseSoftwareOpenGL);
+    qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+}
+
+int CommandLine::run()
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders .g files without a main window.\n"
+                                     "Without a display server the offscreen platform is used, which is enough for "
+                                     "--raytrace.\nThumbnails and benchmarks need OpenGL, run them under xvfb-run "
+                                     "there.");
+    const QCommandLineOption helpOption("help-commands", "Shows this help.");
+    const QCommandLineOption thumbnailsOption("thumbnails", "Writes a thumbnail of each file into <directory>.",
+                                              "directory");
+    const QCommandLineOption benchmarkOption("benchmark", "Renders <frames> frames around the file and prints their "
+                                                          "times as CSV.", "frames");
+    const QCommandLineOption raytraceOption("raytrace", "Raytraces views of the file into files named by <pattern>, "
+                                                        "with {file}, {view} and {index}.", "pattern");
+    const QCommandLineOption viewsOption("views", "Views to raytrace: standard (top, front, side and iso), turntable "
+                                                  "or both, separated by a comma. Both by default.", "views");
+    const QCommandLineOption turntableFramesOption("turntable-frames", "Frames of a raytraced turntable, 36 by "
+                                                                      "default.", "N");
+    const QCommandLineOption antiAliasingOption("anti-aliasing", "Supersamples the edges of raytraced images.");
+    const QCommandLineOption backgroundOption("background", "Background color of raytraced images, black by default.",
+                                              "color");
+    const QCommandLineOption sizeOption("size", "Image size, 256x256 for thumbnails and 1280x720 otherwise.",
+                                        "WxH");
+    const QCommandLineOption shadedOption("shaded", "Draws surfaces instead of wireframes where possible.");
+    const QCommandLineOption jobsOption("jobs", "Number of files plotted at the same time, 2 by default.", "N");
+    const QCommandLineOption timeoutOption("timeout", "Seconds to wait for a file to be plotted, 600 by default.",
+                                           "seconds");
+    const QCommandLineOption softwareGlOption("software-gl", "Renders with a software OpenGL implementation.");
+    parser.addOptions({helpOption, thumbnailsOption, benchmarkOption, raytraceOption, viewsOption,
+                       turntableFramesOption, antiAliasingOption, backgroundOption, sizeOption, shadedOption,
+                       jobsOption, timeoutOption, softwareGlOption});
+    parser.addPositionalArgument("files", "The .g files to render.", "file.g...");
+    parser.process(*QCoreApplication::instance());
+
+    QTextStream err(stderr);
+    if (parser.isSet(helpOption)) {
+        QTextStream(stdout) << parser.helpText();
+        return 0;
+    }
+
+    const bool thumbnails = parser.isSet(thumbnailsOption);
+    if (parser.isSet(sizeOption) && !parseSize(parser.value(sizeOption), w, h)) {
+        err << "Invalid size " << parser.value(sizeOption) << ", expected WxH\n";
+        return 1;
+    }
+    if (!parser.isSet(sizeOption)) {
+        w = thumbnails ? 256 : 1280;
+        h = thumbnails ? 256 : 720;
+    }
+    shaded = parser.isSet(shadedOption);
+    if (parser.isSet(jobsOption)) jobs = std::max(1, parser.value(jobsOption).toInt());
+    if (parser.isSet(timeoutOption)) timeoutMs = std::max(1, parser.value(timeoutOption).toInt()) * 1000;
+
+    const QStringList filePaths = parser.positionalArguments();
+    if (filePaths.isEmpty()) {
+        err << "No .g files given\n";
+        return 1;
+    }
+
+    MainWindow::loadTheme();
+    if (thumbnails) return runThumbnails(parser.value(thumbnailsOption), filePaths);
+
+    if (parser.isSet(raytraceOption)) {
+        const QStringList viewSets = parser.isSet(viewsOption) ? parser.value(viewsOption).split(',')
+                                                               : QStringList({"standard", "turntable"});
+        const int turntableFrames = parser.isSet(turntableFramesOption) ?
+                                    parser.value(turntableFramesOption).toInt() : 36;
+        const QColor background(parser.isSet(backgroundOption) ? parser.value(backgroundOption) : "black");
+        if (filePaths.size() != 1 || turntableFrames <= 0 || !background.isValid()) {
+            err << "--raytrace takes a single file, a positive number of turntable frames and a valid color\n";
+            return 1;
+        }
+        return runRaytrace(parser.value(raytraceOption), viewSets, turntableFrames, parser.isSet(antiAliasingOption),
+                           background, filePaths[0]);
+    }
+
+    const int frames = parser.value(benchmarkOption).toInt();
+    if (frames <= 0 || filePaths.size() != 1) {
+        err << "--benchmark takes a positive number of frames and a single file\n";
+        return 1;
+    }
+    return runBenchmark(frames, filePaths[0]);
+}
+
+/*
+ * Up to jobs documents are open at the same time. Their objects are plotted on the worker threads of each document's
+ * GeometryPlotter while this thread renders a frame of every open document in turn, which adds whatever finished.
+ * A thumbnail is written once its document is completely plotted (or the timeout passed) and the next file is opened.
+ */
+int CommandLine::runThumbnails(const QString& directory, const QStringList& filePaths)
+{
+    QTextStream err(stderr);
+    const QDir outputDirectory(directory);
+    if (!outputDirectory.mkpath(".")) {
+        err << "Failed to create " << directory << "\n";
+        return 1;
+    }
+
+    int failedCount = 0;
+    int nextFile = 0;
+    QVector<ThumbnailJob> running;
+    while (nextFile < filePaths.size() || !running.isEmpty()) {
+        while (running.size() < jobs && nextFile < filePaths.size()) {
+            ThumbnailJob job;
+            job.filePath = filePaths[nextFile];
+            job.document = openDocument(job.filePath, nextFile++);
+            if (job.document == nullptr) {
+                failedCount++;
+                continue;
+            }
+            job.renderer = createRenderer(job.document);
+            if (job.renderer == nullptr) {
+                // no file can be rendered without a context
+                closeDocument(job.document);
+                for (ThumbnailJob& runningJob : running) {
+                    delete runningJob.renderer;
+                    closeDocument(runningJob.document);
+                }
+                return 1;
+            }
+            job.timer.start();
+            running.append(job);
+        }
+
+        bool anyFinished = false;
+        for (int i = running.size() - 1; i >= 0; i--) {
+            ThumbnailJob& job = running[i];
+            const GeometryRenderer* geometryRenderer = job.document->getGeometryRenderer();
+            anyFinished |= geometryRenderer->getPlotter()->hasFinished();
+            job.renderer->renderFrame();
+            const bool complete = geometryRenderer->isComplete();
+            if (!complete && job.timer.elapsed() < timeoutMs) continue;
+
+            if (!complete) err << job.filePath << ": not completely plotted after " << timeoutMs / 1000 << "s\n";
+            job.renderer->getView()->getCamera()->autoview();
+            job.renderer->renderFrame();
+            const QString imagePath = outputDirectory.filePath(QFileInfo(job.filePath).completeBaseName() + ".png");
+            if (!job.renderer->grabImage().save(imagePath)) {
+                err << "Failed to write " << imagePath << "\n";
+                failedCount++;
+            }
+
+            delete job.renderer;
+            closeDocument(job.document);
+            running.removeAt(i);
+        }
+
+        QCoreApplication::processEvents();
+        if (!anyFinished) QThread::msleep(5);
+    }
+
+    return failedCount == 0 ? 0 : 1;
+}
+
+/*
+ * The camera turns around the vertical axis by 360/frames degrees each frame, starting from the default orientation
+ * after an autoview, so runs on different machines draw the same frames. Each frame is timed until the GPU finished
+ * it. The first frame after plotting is not timed, it uploads the geometry.
+ */
+int CommandLine::runBenchmark(const int frames, const QString& filePath)
+{
+    QTextStream err(stderr);
+    Document* document = openDocument(filePath, 0);
+    if (document == nullptr) return 1;
+    OffscreenRenderer* renderer = createRenderer(document);
+    if (renderer == nullptr) {
+        closeDocument(document);
+        return 1;
+    }
+
+    if (!renderer->renderUntilComplete(timeoutMs)) {
+        err << filePath << ": not completely plotted after " << timeoutMs / 1000 << "s\n";
+    }
+    renderer->getView()->getCamera()->autoview();
+    renderer->renderFrame();
+    renderer->finish();
+
+    OrthographicCamera* camera = renderer->getView()->getCamera();
+    const QVector3D startAngles = camera->getAnglesAroundAxes();
+    QVector<double> frameTimesMs;
+    frameTimesMs.reserve(frames);
+    QElapsedTimer timer;
+    for (int i = 0; i < frames; i++) {
+        camera->setAnglesAroundAxes(startAngles.x(), startAngles.y(), startAngles.z() + 360.f * i / frames);
+        timer.start();
+        renderer->renderFrame();
+        renderer->finish();
+        frameTimesMs.append(timer.nsecsElapsed() / 1e6);
+    }
+
+    double totalMs = 0;
+    for (double frameTimeMs : frameTimesMs) totalMs += frameTimeMs;
+    std::sort(frameTimesMs.begin(), frameTimesMs.end());
+    const GeometryRenderer* geometryRenderer = document->getGeometryRenderer();
+
+    QTextStream out(stdout);
+    out << "file,renderer,width,height,shaded,frames,objects drawn,draw calls,vertices,"
+           "mean ms,median ms,p95 ms,max ms,fps\n";
+    out << QFileInfo(filePath).fileName() << ",\"" << renderer->getRendererName() << "\","
+        << renderer->getW() << "," << renderer->getH() << "," << (shaded ? 1 : 0) << "," << frames << ","
+        << geometryRenderer->getDrawnObjectCount() << "," << geometryRenderer->getDrawCallCount() << ","
+        << geometryRenderer->getSubmittedVertexCount() << ","
+        << totalMs / frames << "," << frameTimesMs[frames / 2] << ","
+        << frameTimesMs[std::min(frames - 1, frames * 95 / 100)] << "," << frameTimesMs.last() << ","
+        << 1000. * frames / totalMs << "\n";
+
+    delete renderer;
+    closeDocument(document);
+    return 0;
+}
+
+int CommandLine::runRaytrace(const QString& outputPattern, const QStringList& viewSets, const int turntableFrames,
+                             const bool antiAliasing, const QColor& background, const QString& filePath)
+{
+    QTextStream err(stderr);
+    if (!RaytraceBatch::isValidPattern(outputPattern)) {
+        err << "The output pattern needs {view} or {index}, so each view gets a file of its own\n";
+        return 1;
+    }
+    QVector<RaytraceBatch::View> views;
+    for (const QString& viewSet : viewSets) {
+        if (viewSet.trimmed() == "standard") views += RaytraceBatch::standardViews();
+        else if (viewSet.trimmed() == "turntable") views += RaytraceBatch::turntableViews(turntableFrames);
+        else {
+            err << "Unknown views " << viewSet << ", expected standard or turntable\n";
+            return 1;
+        }
+    }
+
+    // the display widgets of the document are created (on the offscreen platform without a display server) but never
+    // shown, so they do not make an OpenGL context
+    Document* document = openDocument(filePath, 0);
+    if (document == nullptr) return 1;
+
+    QVector<RaytraceBatch::Frame> frames;
+    {
+        RaytraceBatch batch(document, w, h);
+        batch.setBackground(background);
+        batch.setAntiAliasingEnabled(antiAliasing);
+        frames = batch.run(views, outputPattern);
+    }
+
+    int failedCount = 0;
+    QTextStream out(stdout);
+    out << "index,view,file,trace ms,written\n";
+    for (int i = 0; i < frames.size(); i++) {
+        out << i << "," << frames[i].viewName << ",\"" << frames[i].filePath << "\"," << frames[i].traceMs << ","
+            << (frames[i].written ? 1 : 0) << "\n";
+        if (!frames[i].written) failedCount++;
+    }
+    if (failedCount > 0) err << failedCount << " of " << frames.size() << " images could not be written\n";
+
+    closeDocument(document);
+    return failedCount == 0 ? 0 : 1;
+}
+
+Document* CommandLine::openDocument(const QString& filePath, const int documentId)
+{
+    try {
+        return new Document(nullptr, documentId, &filePath);
+    }
+    catch (const std::runtime_error& e) {
+        QTextStream(stderr) << filePath << ": " << e.what() << "\n";
+        return nullptr;
+    }
+}
+
+// the widgets of a document are owned by the main window's tabs and docks, here nobody else deletes them. The
+// document deletes its raytrace view itself
+void CommandLine::closeDocument(Document* document)
+{
+    delete document->getDisplayGrid();
+    delete document->getObjectTreeWidget();
+    delete document->getProperties();
+    delete document;
+}
+
+OffscreenRenderer* CommandLine::createRenderer(Document* document)
+{
+    OffscreenRenderer* renderer = new OffscreenRenderer(document, w, h);
+    if (!renderer->isValid()) {
+        QTextStream(stderr) << "No OpenGL context available, try --software-gl\n";
+        delete renderer;
+        return nullptr;
+    }
+    renderer->getView()->shadedModeEnabled = shaded;
+    renderer->getView()->axesEnabled = false;
+    return renderer;
+}
@@ -5,6 +5,7 @@
 #include <Document.h>
 #include<Display.h>
 #include <brlcad/Torus.h>
+#include <QMutex>
 #include "MainWindow.h"
 
 
@@ -19,12 +20,14 @@ Document::Document(MainWindow* mainWindow, const int documentId, const QString *
     }
 
     modified = false;
-    objectTree = new ObjectTree(database);
+    objectTree = new ObjectTree(database, filePath);
     properties = new Properties(*this);
     geometryRenderer = new GeometryRenderer(this);
+    frameScheduler = new FrameScheduler();
     objectTreeWidget = new ObjectTreeWidget(this);
     vvWidget = nullptr;
-    if (filePath) loadVerificationValidationWidget();
+    // documents opened without a main window (see CommandLine) have no dockable for the verification results
+    if (filePath && mainWindow) loadVerificationValidationWidget();
     displayGrid = new DisplayGrid(this);
 
     displayGrid->forceRerenderAllDisplays();
@@ -33,24 +36,39 @@ Document::Document(MainWindow* mainWindow, const int documentId, const QString *
 }
 
 Document::~Document() {
+    delete raytraceWidget; // stops its raytrace and frees the worker databases
     delete vvWidget; // remove sqlite connection
+    delete geometryRenderer; // waits for plots using the database
+    delete frameScheduler;
     delete database;
 }
 
 void Document::modifyObject(BRLCAD::Object *newObject) {
     modified = true;
-    database->Set(*newObject);
-    QString objectName = newObject->Name();
-    getObjectTree()->traverseSubTree(0,false,[this, objectName]
+    databaseRevision++;
+    if (geometryRenderer->getPlotCache()) geometryRenderer->getPlotCache()->objectModified(newObject->Name());
+    {
+        QMutexLocker locker(geometryRenderer->getPlotter()->getDatabaseMutex());
+        database->Set(*newObject);
+    }
+    const QString objectName = newObject->Name();
+    const QHash<int, QString>& nameMap = getObjectTree()->getNameMap();
+
+    // the search only reads the tree, so it can be spread over the thread pool
+    QVector<int> modifiedObjectIds;
+    QMutex modifiedObjectIdsMutex;
+    getObjectTree()->parallelTraverse(0, false, [&nameMap, &objectName, &modifiedObjectIds, &modifiedObjectIdsMutex]
     (int objectId){
-        if (getObjectTree()->getNameMap()[objectId] == objectName){
-            geometryRenderer->clearObject(objectId);
+        if (nameMap.value(objectId) == objectName){
+            QMutexLocker locker(&modifiedObjectIdsMutex);
+            modifiedObjectIds.append(objectId);
         }
         return true;
     }
     );
+    for (int objectId : modifiedObjectIds) geometryRenderer->clearObject(objectId);
     geometryRenderer->refreshForVisibilityAndSolidChanges();
-    for (Display * display : displayGrid->getDisplays())display->forceRerenderFrame();
+    displayGrid->forceRerenderAllDisplays();
 }
 
 bool Document::isModified() {
@@ -59,12 +77,90 @@ bool Document::isModified() {
 
 bool Document::Add(const BRLCAD::Object& object) {
     modified = true;
+    databaseRevision++;
+    if (geometryRenderer->getPlotCache()) geometryRenderer->getPlotCache()->objectModified(object.Name());
+    QMutexLocker locker(geometryRenderer->getPlotter()->getDatabaseMutex());
     return database->Add(object);
 }
 
 bool Document::Save(const char* fileName) {
     modified = false;
-    return database->Save(fileName);
+    QMutexLocker locker(geometryRenderer->getPlotter()->getDatabaseMutex());
+    if (!database->Save(fileName)) return false;
+    if (geometryRenderer->getPlotCache()) geometryRenderer->getPlotCache()->fileSaved(fileName);
+    return true;
+}
+
+bool Document::saveCopy(const QString& fileName) {
+    QMutexLocker locker(geometryRenderer->getPlotter()->getDatabaseMutex());
+    return database->Save(fileName.toUtf8());
+}
+
+bool Document::containsObject(const QString& objectName) {
+    BRLCAD::Object* object = getObjectCopy(objectName);
+    const bool found = object != nullptr;
+    delete object;
+    return found;
+}
+
+BRLCAD::Object* Document::getObjectCopy(const QString& objectName) {
+    QMutexLocker locker(geometryRenderer->getPlotter()->getDatabaseMutex());
+    return database->Get(objectName.toUtf8());
+}
+
+// the tree reads the new object and its members from the database
+int Document::addTopObject(const QString& name) {
+    QMutexLocker locker(geometryRenderer->getPlotter()->getDatabaseMutex());
+    return objectTree->addTopObject(name);
+}
+
+QStringList Document::getVisibleObjectPaths() {
+    QStringList paths;
+    objectTree->traverse(0, false, [this, &paths](int objectId) {
+        switch (objectTree->getObjectVisibility()[objectId]) {
+            case ObjectTree::Invisible:
+                return false;
+            case ObjectTree::SomeChildrenVisible:
+                return true;
+            case ObjectTree::FullyVisible:
+                paths.append(objectTree->getFullPathMap()[objectId]);
+                return false;
+        }
+        return true;
+    });
+    return paths;
+}
+
+// the signature rules out most changes quickly, the paths are compared in case two selections hash the same
+void Document::selectObjects(const QStringList& paths) {
+    const quint64 signature = selectionSignature(paths, databaseRevision);
+    QStringList sortedPaths = paths;
+    sortedPaths.sort();
+    if (signature == selectedPathsSignature && databaseRevision == selectedPathsRevision &&
+        sortedPaths == selectedPaths) {
+        return;
+    }
+
+    QMutexLocker locker(geometryRenderer->getPlotter()->getDatabaseMutex());
+    database->UnSelectAll();
+    for (const QString& path : paths) database->Select(path.toUtf8());
+    selectedPathsSignature = signature;
+    selectedPaths = sortedPaths;
+    selectedPathsRevision = databaseRevision;
+}
+
+void Document::getSelectionBoundingBox(BRLCAD::Vector3D& minima, BRLCAD::Vector3D& maxima) {
+    QMutexLocker locker(geometryRenderer->getPlotter()->getDatabaseMutex());
+    minima = database->BoundingBoxMinima();
+    maxima = database->BoundingBoxMaxima();
+}
+
+// 0 is never returned, it stands for nothing selected yet
+quint64 Document::selectionSignature(const QStringList& paths, const quint64 databaseRevision) {
+    QStringList sortedPaths = paths;
+    sortedPaths.sort();
+    const uint hash = qHashRange(sortedPaths.constBegin(), sortedPaths.constEnd(), qHash(databaseRevision));
+    return (static_cast<quint64>(sortedPaths.size() + 1) << 32) | hash;
 }
 
 class BRLCADConstObjectCallback : public BRLCAD::ConstDatabase::ObjectCallback {
@@ -81,6 +177,7 @@ private:
 
 void Document::getBRLCADConstObject(const QString& objectName, const std::function<void(const BRLCAD::Object&)>& func) {
     BRLCADConstObjectCallback callback(func);
+    QMutexLocker locker(geometryRenderer->getPlotter()->getDatabaseMutex());
     database->Get(objectName.toUtf8(), callback);
 }
 
@@ -98,8 +195,14 @@ private:
 
 void Document::getBRLCADObject(const QString& objectName, const std::function<void(BRLCAD::Object&)>& func) {
     BRLCADObjectCallback callback(func);
-    database->Get(objectName.toUtf8(), callback);
+    if (geometryRenderer->getPlotCache()) geometryRenderer->getPlotCache()->objectModified(objectName.split('/').last());
+    {
+        // func changes the object, which is written back to the database when it returns
+        QMutexLocker locker(geometryRenderer->getPlotter()->getDatabaseMutex());
+        database->Get(objectName.toUtf8(), callback);
+    }
     modified = true;
+    databaseRevision++;
 }
 
 Display* Document::getDisplay()
@@ -108,6 +211,7 @@ Display* Document::getDisplay()
 }
 
 int Document::getTabIndex() {
+    if (mainWindow == nullptr) return -1;
     return mainWindow->getDocumentArea()->indexOf(getDisplayGrid());
 }
 
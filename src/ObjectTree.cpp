@@ -28,6 +28,7 @@
 
 #include <brlcad/Combination.h>
 #include "ObjectTree.h"
+#include "ObjectTreeCache.h"
 #include <QStandardItemModel>
 #include "MemoryDatabase.h"
 
@@ -35,19 +36,36 @@
 void ObjectTree::ObjectTreeCallback::operator()(const BRLCAD::Object& object)
 {
 	objectId = ++objectTree->lastAllocatedId;
+	objectTree->reserveObjectId(objectId);
     objectTree->getChildren()[objectId] = QVector<int>();
 	objectTree->objectIdParentObjectIdMap[objectId] = parentObjectId;
 	childrenNames = &objectTree->getChildren()[objectId];
 
 	objectTree->getFullPathMap()[objectId] = currentObjectPath;
 
+	// the parent has already been processed, so its (inherited) color is final by now
+	ColorInfo color = objectTree->colorMap[parentObjectId];
+	ObjectInfo info;
+	info.typeIndex = objectTree->objectTypeIndex(object.Type());
 
 	if (const BRLCAD::Combination* combination = dynamic_cast<const BRLCAD::Combination*>(&object)) {
+		if (combination->HasColor()) {
+			color.red = combination->Red();
+			color.green = combination->Green();
+			color.blue = combination->Blue();
+			color.hasColor = true;
+		}
+		info.isRegion = combination->IsRegion();
+		info.regionId = combination->RegionId();
 
+		objectTree->colorMap[objectId] = color;
+		objectTree->objectInfo[objectId] = info;
 		traverseSubTree(combination->Tree());
 	}
 	else
 	{
+		objectTree->colorMap[objectId] = color;
+		objectTree->objectInfo[objectId] = info;
 		objectTree->getDrawableObjectIds().insert(objectId);
 	}
 }
@@ -72,6 +90,7 @@ void ObjectTree::ObjectTreeCallback::traverseSubTree(const BRLCAD::Combination::
         objectTree->getChildren()[objectId].append(objectTree->lastAllocatedId + 1);
 		QString childName = QString(node.Name());
 		objectTree->getNameMap()[objectTree->lastAllocatedId + 1] = childName;
+		objectTree->reserveObjectId(objectTree->lastAllocatedId + 1);
 		ObjectTreeCallback callback(objectTree, childName, objectId);
 		objectTree->getDatabase()->Get(node.Name(), callback);
 	}
@@ -83,20 +102,34 @@ int ObjectTree::addTopObject(QString name) {
     int topObjectId = lastAllocatedId + 1;
 	childrenNames->append(topObjectId);
 	getNameMap()[topObjectId] = name;
+	reserveObjectId(topObjectId);
 	ObjectTreeCallback callback(this, name, 0);
 	database->Get(name.toUtf8(), callback);
-    buildColorMap(topObjectId);
 	return topObjectId;
 }
 
 
-ObjectTree::ObjectTree(BRLCAD::MemoryDatabase* database) : database(database) {
+ObjectTree::ObjectTree(BRLCAD::MemoryDatabase* database, const QString* filePath) : database(database) {
+	if (filePath == nullptr) {
+		build();
+		return;
+	}
+
+	ObjectTreeCache cache(*filePath);
+	if (cache.load(this)) return;
+	build();
+	cache.save(this);
+}
+
+void ObjectTree::build() {
 	BRLCAD::ConstDatabase::TopObjectIterator it = database->FirstTopObject();
 
+	reserveObjectId(0);
     objectIdChildrenObjectIdsMap[0] = QVector<int>(); // objectId of root is 0
     objectIdParentObjectIdMap[0] = -1;
 	nameMap[0] = "";
 	colorMap[0] = {1,1,1,false };
+	objectTypeIndex("");
 
 
 	while (it.Good()) {
@@ -109,11 +142,7 @@ ObjectTree::ObjectTree(BRLCAD::MemoryDatabase* database) : database(database) {
 
 void ObjectTree::traverseSubTree(const int rootOfSubTreeId, bool traverseRoot, const std::function<bool(int)>& callback)
 {
-	if(traverseRoot) callback(rootOfSubTreeId);
-	for (int objectId : objectIdChildrenObjectIdsMap[rootOfSubTreeId]) {
-		if (!callback(objectId)) continue;
-		if (objectIdChildrenObjectIdsMap.contains(rootOfSubTreeId)) traverseSubTree(objectId, false, callback);
-	}
+	traverse(rootOfSubTreeId, traverseRoot, callback);
 }
 
 
@@ -137,7 +166,7 @@ void ObjectTree::changeVisibilityState(int objectId, bool visible) {
         }
 
         // All children of objectId should be fully visible
-        traverseSubTree(objectId, false,[this] (int childId){
+        traverse(objectId, false,[this] (int childId){
             objectIdVisibilityStateMap[childId] = FullyVisible;
             return true;
         });
@@ -162,28 +191,28 @@ void ObjectTree::changeVisibilityState(int objectId, bool visible) {
         }
 
         // All children of objectId should be invisible
-        traverseSubTree(objectId, false,[this] (int childId){
+        traverse(objectId, false,[this] (int childId){
             objectIdVisibilityStateMap[childId] = Invisible;
             return true;
         });
     }
 }
 
-void ObjectTree::buildColorMap(int rootObjectId) {
-	traverseSubTree(rootObjectId,true,[&](int objectId){
-		if(objectId==0)return true;
-		const QString objectName = fullPathMap[objectId];
-		const QByteArray &name = objectName.toUtf8();
-		BRLCAD::Object *object = database->Get(name);
-		colorMap[objectId] = ColorInfo(colorMap[objectIdParentObjectIdMap[objectId]]);
-		if(const BRLCAD::Combination* combination = dynamic_cast<const BRLCAD::Combination*>(object)) {
-			if (combination->HasColor()) {
-				colorMap[objectId].red = combination->Red();
-				colorMap[objectId].green = combination->Green();
-				colorMap[objectId].blue = combination->Blue();
-				colorMap[objectId].hasColor = true;
-			}
-		}
-		return true;
-	});
+void ObjectTree::reserveObjectId(int objectId) {
+	if (colorMap.size() <= objectId) {
+		objectIdChildrenObjectIdsMap.resize(objectId + 1);
+		colorMap.resize(objectId + 1);
+		objectInfo.resize(objectId + 1);
+	}
+}
+
+quint16 ObjectTree::objectTypeIndex(const char* type) {
+	const QString typeName(type);
+	QHash<QString, quint16>::const_iterator it = objectTypeIndices.constFind(typeName);
+	if (it != objectTypeIndices.constEnd()) return it.value();
+
+	const quint16 index = objectTypes.size();
+	objectTypes.append(typeName);
+	objectTypeIndices[typeName] = index;
+	return index;
 }
@@ -0,0 +1,124 @@
+/*        B O U N D I N G V O L U M E H I E R A R C H Y . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file BoundingVolumeHierarchy.cpp */
+
+#include <algorithm>
+#include "BoundingVolumeHierarchy.h"
+
+
+void BoundingVolumeHierarchy::build(const QVector<Item>& items)
+{
+    clear();
+    QVector<Item> sortedItems;
+    sortedItems.reserve(items.size());
+    for (const Item& item : items) {
+        if (!item.box.isEmpty()) sortedItems.append(item);
+    }
+    if (sortedItems.isEmpty()) return;
+
+    nodes.reserve(2 * sortedItems.size() / maxLeafSize + 1);
+    nodes.append(Node());
+    buildNode(sortedItems, 0, sortedItems.size(), 0);
+
+    objectIds.reserve(sortedItems.size());
+    boxes.reserve(sortedItems.size());
+    for (const Item& item : sortedItems) {
+        objectIds.append(item.objectId);
+        boxes.append(item.box);
+    }
+}
+
+void BoundingVolumeHierarchy::clear()
+{
+    nodes.clear();
+    objectIds.clear();
+    boxes.clear();
+}
+
+// splits at the median of the box centers along the longest axis of the node
+void BoundingVolumeHierarchy::buildNode(QVector<Item>& items, int first, int count, int nodeIndex)
+{
+    AxisAlignedBox box;
+    AxisAlignedBox centers;
+    for (int i = first; i < first + count; i++) {
+        box.add(items[i].box);
+        centers.add(items[i].box.center());
+    }
+
+    nodes[nodeIndex].box = box;
+    nodes[nodeIndex].first = first;
+    nodes[nodeIndex].count = count;
+    nodes[nodeIndex].left = -1;
+    if (count <= maxLeafSize) return;
+
+    const QVector3D extent = centers.size();
+    int axis = 0;
+    if (extent.y() > extent[axis]) axis = 1;
+    if (extent.z() > extent[axis]) axis = 2;
+
+    const int half = count / 2;
+    std::nth_element(items.begin() + first, items.begin() + first + half, items.begin() + first + count,
+                     [axis](const Item& a, const Item& b) {
+                         return a.box.center()[axis] < b.box.center()[axis];
+                     });
+
+    const int left = nodes.size();
+    nodes.append(Node());
+    nodes.append(Node());
+    nodes[nodeIndex].left = left;
+    buildNode(items, first, half, left);
+    buildNode(items, first + half, count - half, left + 1);
+}
+
+void BoundingVolumeHierarchy::query(const ViewFrustum& frustum, QBitArray& objectsInFrustum) const
+{
+    if (nodes.isEmpty()) return;
+
+    QVector<int> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const Node& node = nodes[stack.takeLast()];
+        switch (frustum.intersect(node.box)) {
+            case ViewFrustum::Outside:
+                break;
+            case ViewFrustum::Inside:
+                setBits(node.first, node.count, objectsInFrustum);
+                break;
+            case ViewFrustum::Intersecting:
+                if (node.left < 0) {
+                    for (int i = node.first; i < node.first + node.count; i++) {
+                        if (frustum.intersect(boxes[i]) != ViewFrustum::Outside) setBits(i, 1, objectsInFrustum);
+                    }
+                }
+                else {
+                    stack.append(node.left);
+                    stack.append(node.left + 1);
+                }
+                break;
+        }
+    }
+}
+
+void BoundingVolumeHierarchy::setBits(int first, int count, QBitArray& objectsInFrustum) const
+{
+    for (int i = first; i < first + count; i++) {
+        if (objectIds[i] < objectsInFrustum.size()) objectsInFrustum.setBit(objectIds[i]);
+    }
+}
@@ -22,6 +22,7 @@
 #include "Display.h"
 
 #include <iostream>
+#include <QPainter>
 #include <QWidget>
 #include <OrthographicCamera.h>
 #include <include/Globals.h>
@@ -38,24 +39,32 @@ Display::Display(Document*  document)
     displayManager = new DisplayManager(*this);
     axesRenderer = new AxesRenderer();
     gridRenderer = new GridRenderer(this);
+    frameStatistics = new FrameStatistics();
+    objectPicker = new ObjectPicker(this);
 
     bgColor = Globals::theme->getColor("$Color-GraphicsView");
     displayManager->setBGColor(bgColor.redF(),bgColor.greenF(),bgColor.blueF());
 
-    makeCurrent();
-    update();
+    document->getFrameScheduler()->addDisplay(this);
+    forceRerenderFrame();
 }
 
 Display::~Display() {
+    makeCurrent();
+    frameStatistics->releaseQueries();
+    delete gridRenderer;
+    delete objectPicker;
+    doneCurrent();
+    delete frameStatistics;
     delete camera;
     delete displayManager;
     delete axesRenderer;
 }
 
 
+// the frame is drawn by the document's FrameScheduler, together with other requests of the same event
 void Display::forceRerenderFrame() {
-    makeCurrent();
-    update();
+    document->getFrameScheduler()->requestFrame(this);
 }
 
 int Display::getW() const {
@@ -76,20 +85,35 @@ DisplayManager* Display::getDisplayManager() const
 	return displayManager;
 }
 
-void Display::resizeGL(const int w, const int h) {
+FrameStatistics* Display::getFrameStatistics() const
+{
+    return frameStatistics;
+}
+
+ObjectPicker* Display::getObjectPicker() const
+{
+    return objectPicker;
+}
+
+void Display::setSize(const int w, const int h) {
     camera->setWH(w,h);
     this->w = w;
     this->h = h;
 }
 
-void Display::paintGL() {
+void Display::resizeGL(const int w, const int h) {
+    setSize(w, h);
+}
+
+void Display::drawScene() {
     displayManager->drawBegin();
 
     glViewport(0,0,w,h);
     displayManager->loadMatrix(camera->modelViewMatrix().data());
     displayManager->loadPMatrix(camera->projectionMatrix().data());
-    document->getGeometryRenderer()->render();
+    document->getGeometryRenderer()->render(this);
     if(gridEnabled)gridRenderer->render();
+    if (!axesEnabled) return;
 
     glViewport(w*.88,h*.02,w/10,w/10);
     displayManager->loadMatrix(camera->modelViewMatrixNoTranslate().data());
@@ -99,6 +123,33 @@ void Display::paintGL() {
     axesRenderer->render();
 }
 
+void Display::paintGL() {
+    const bool collectStatistics = statisticsOverlayEnabled || frameStatistics->isWritingCsv();
+    if (collectStatistics) frameStatistics->beginFrame();
+
+    drawScene();
+
+    if (collectStatistics) {
+        const GeometryRenderer* geometryRenderer = document->getGeometryRenderer();
+        FrameStatistics::Counters counters;
+        counters.drawCalls = geometryRenderer->getDrawCallCount();
+        counters.verticesSubmitted = geometryRenderer->getSubmittedVertexCount();
+        counters.objectsDrawn = geometryRenderer->getDrawnObjectCount();
+        counters.objectsCulled = geometryRenderer->getCulledObjectCount();
+        counters.plotQueueDepth = geometryRenderer->getPlotter()->getPendingCount();
+        frameStatistics->endFrame(counters);
+    }
+    if (statisticsOverlayEnabled) {
+        QPainter painter(this);
+        frameStatistics->drawOverlay(painter);
+    }
+}
+
+void Display::showEvent(QShowEvent *event) {
+    QOpenGLWidget::showEvent(event);
+    forceRerenderFrame();
+}
+
 void Display::keyPressEvent( QKeyEvent *k ) {
     switch (k->key()) {
         case Qt::Key_Up:
@@ -38,12 +38,12 @@ bool DisplayManager::DrawVListElementCallback::operator()(BRLCAD::VectorList::El
     switch (element->Type()) {
 
         case BRLCAD::VectorList::Element::LineDraw: {
-            BRLCAD::VectorList::LineDraw *e = dynamic_cast<BRLCAD::VectorList::LineDraw *> (element);
+            BRLCAD::VectorList::LineDraw *e = static_cast<BRLCAD::VectorList::LineDraw *> (element);
             glVertex3dv(e->Point().coordinates);
             break;
         }
         case BRLCAD::VectorList::Element::LineMove: {
-            BRLCAD::VectorList::LineMove *e = dynamic_cast<BRLCAD::VectorList::LineMove *> (element);
+            BRLCAD::VectorList::LineMove *e = static_cast<BRLCAD::VectorList::LineMove *> (element);
             if (vars->first == 0) glEnd();
             vars->first = 0;
 
@@ -72,7 +72,7 @@ bool DisplayManager::DrawVListElementCallback::operator()(BRLCAD::VectorList::El
             break;
         }
         case BRLCAD::VectorList::Element::DisplaySpace: {
-            BRLCAD::VectorList::DisplaySpace *e = dynamic_cast<BRLCAD::VectorList::DisplaySpace *> (element);
+            BRLCAD::VectorList::DisplaySpace *e = static_cast<BRLCAD::VectorList::DisplaySpace *> (element);
             glMatrixMode(GL_MODELVIEW);
             GLfloat _m[16];
             glGetFloatv(GL_MODELVIEW_MATRIX, _m);
@@ -91,7 +91,7 @@ bool DisplayManager::DrawVListElementCallback::operator()(BRLCAD::VectorList::El
             break;
         }
         case BRLCAD::VectorList::Element::PolygonStart: {
-            BRLCAD::VectorList::PolygonStart *e = dynamic_cast<BRLCAD::VectorList::PolygonStart *> (element);
+            BRLCAD::VectorList::PolygonStart *e = static_cast<BRLCAD::VectorList::PolygonStart *> (element);
             if (displayManager->dmLight && vars->mFlag) {
                 vars->mFlag = 0;
                 glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, black);
@@ -126,7 +126,7 @@ bool DisplayManager::DrawVListElementCallback::operator()(BRLCAD::VectorList::El
             break;
         }
         case BRLCAD::VectorList::Element::TriangleStart: {
-            BRLCAD::VectorList::TriangleStart *e = dynamic_cast<BRLCAD::VectorList::TriangleStart *> (element);
+            BRLCAD::VectorList::TriangleStart *e = static_cast<BRLCAD::VectorList::TriangleStart *> (element);
             if (displayManager->dmLight && vars->mFlag) {
                 vars->mFlag = 0;
                 glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, black);
@@ -162,27 +162,27 @@ bool DisplayManager::DrawVListElementCallback::operator()(BRLCAD::VectorList::El
             break;
         }
         case BRLCAD::VectorList::Element::PolygonMove: {
-            BRLCAD::VectorList::PolygonMove *e = dynamic_cast<BRLCAD::VectorList::PolygonMove *> (element);
+            BRLCAD::VectorList::PolygonMove *e = static_cast<BRLCAD::VectorList::PolygonMove *> (element);
             glVertex3dv(e->Point().coordinates);
             break;
         }
         case BRLCAD::VectorList::Element::PolygonDraw: {
-            BRLCAD::VectorList::PolygonDraw *e = dynamic_cast<BRLCAD::VectorList::PolygonDraw *> (element);
+            BRLCAD::VectorList::PolygonDraw *e = static_cast<BRLCAD::VectorList::PolygonDraw *> (element);
             glVertex3dv(e->Point().coordinates);
             break;
         }
         case BRLCAD::VectorList::Element::TriangleMove: {
-            BRLCAD::VectorList::TriangleMove *e = dynamic_cast<BRLCAD::VectorList::TriangleMove *> (element);
+            BRLCAD::VectorList::TriangleMove *e = static_cast<BRLCAD::VectorList::TriangleMove *> (element);
             glVertex3dv(e->Point().coordinates);
             break;
         }
         case BRLCAD::VectorList::Element::TriangleDraw: {
-            BRLCAD::VectorList::TriangleDraw *e = dynamic_cast<BRLCAD::VectorList::TriangleDraw *> (element);
+            BRLCAD::VectorList::TriangleDraw *e = static_cast<BRLCAD::VectorList::TriangleDraw *> (element);
             glVertex3dv(e->Point().coordinates);
             break;
         }
         case BRLCAD::VectorList::Element::PolygonEnd: {
-            BRLCAD::VectorList::PolygonEnd *e = dynamic_cast<BRLCAD::VectorList::PolygonEnd *> (element);
+            BRLCAD::VectorList::PolygonEnd *e = static_cast<BRLCAD::VectorList::PolygonEnd *> (element);
             glVertex3dv(e->Point().coordinates);
             glEnd();
             vars->first = 1;
@@ -192,17 +192,17 @@ bool DisplayManager::DrawVListElementCallback::operator()(BRLCAD::VectorList::El
             break;
         }
         case BRLCAD::VectorList::Element::PolygonVertexNormal: {
-            BRLCAD::VectorList::PolygonVertexNormal *e = dynamic_cast<BRLCAD::VectorList::PolygonVertexNormal *> (element);
+            BRLCAD::VectorList::PolygonVertexNormal *e = static_cast<BRLCAD::VectorList::PolygonVertexNormal *> (element);
             glNormal3dv(e->Normal().coordinates);
             break;
         }
         case BRLCAD::VectorList::Element::TriangleVertexNormal: {
-            BRLCAD::VectorList::TriangleVertexNormal *e = dynamic_cast<BRLCAD::VectorList::TriangleVertexNormal *> (element);
+            BRLCAD::VectorList::TriangleVertexNormal *e = static_cast<BRLCAD::VectorList::TriangleVertexNormal *> (element);
             glNormal3dv(e->Normal().coordinates);
             break;
         }
         case BRLCAD::VectorList::Element::PointDraw: {
-            BRLCAD::VectorList::PointDraw *e = dynamic_cast<BRLCAD::VectorList::PointDraw *> (element);
+            BRLCAD::VectorList::PointDraw *e = static_cast<BRLCAD::VectorList::PointDraw *> (element);
             if (vars->first == 0) glEnd();
             vars->first = 0;
             glBegin(GL_POINTS);
@@ -210,7 +210,7 @@ bool DisplayManager::DrawVListElementCallback::operator()(BRLCAD::VectorList::El
             break;
         }
         case BRLCAD::VectorList::Element::LineWidth: {
-            BRLCAD::VectorList::LineWidth *e = dynamic_cast<BRLCAD::VectorList::LineWidth *> (element);
+            BRLCAD::VectorList::LineWidth *e = static_cast<BRLCAD::VectorList::LineWidth *> (element);
             GLfloat lineWidth = static_cast<GLfloat>(e->Width());
             if (lineWidth > 0.0) {
                 glLineWidth(lineWidth);
@@ -218,7 +218,7 @@ bool DisplayManager::DrawVListElementCallback::operator()(BRLCAD::VectorList::El
             break;
         }
         case BRLCAD::VectorList::Element::PointSize: {
-            BRLCAD::VectorList::PointSize *e = dynamic_cast<BRLCAD::VectorList::PointSize *> (element);
+            BRLCAD::VectorList::PointSize *e = static_cast<BRLCAD::VectorList::PointSize *> (element);
             GLfloat pointSize = static_cast<GLfloat>(e->Size());
             if (pointSize > 0.0) {
                 glPointSize(pointSize);
@@ -293,6 +293,24 @@ void DisplayManager::setFGColor(float r, float g, float b, float transparency) {
 }
 
 
+/*
+ * Sets up lighting and material for drawing lines with the current FG color the same way drawVList does.
+ * Used for geometry that is drawn from buffers rather than from a vector list.
+ */
+void DisplayManager::applyWireMaterial() {
+    const float black[4] = {0.0, 0.0, 0.0, 0.0};
+    if (!dmLight) return;
+
+    glEnable(GL_LIGHTING);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, wireColor);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, black);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, black);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, black);
+
+    if (dmTransparency) glDisable(GL_BLEND);
+}
+
+
 void DisplayManager::setBGColor(float r, float g, float b) {
     bgColor[0] = r;
     bgColor[1] = g;
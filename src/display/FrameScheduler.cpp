@@ -0,0 +1,82 @@
+/*                 F R A M E S C H E D U L E R . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file FrameScheduler.cpp */
+
+#include <QTimer>
+#include "FrameScheduler.h"
+#include "Display.h"
+
+
+FrameScheduler::FrameScheduler(QObject* parent) : QObject(parent) {}
+
+void FrameScheduler::addDisplay(Display* display)
+{
+    displayStates[display] = DisplayState();
+    connect(display, &QOpenGLWidget::frameSwapped, this, [this, display]() {
+        frameSwapped(display);
+    });
+    connect(display, &QObject::destroyed, this, [this, display]() {
+        displayStates.remove(display);
+    });
+}
+
+void FrameScheduler::requestFrame(Display* display)
+{
+    QHash<Display*, DisplayState>::iterator state = displayStates.find(display);
+    if (state == displayStates.end()) return;
+    state->dirty = true;
+    scheduleFlush();
+}
+
+void FrameScheduler::requestAllFrames()
+{
+    for (DisplayState& state : displayStates) state.dirty = true;
+    scheduleFlush();
+}
+
+// everything requested until control gets back to the event loop ends up in one flush
+void FrameScheduler::scheduleFlush()
+{
+    if (flushScheduled) return;
+    flushScheduled = true;
+    QTimer::singleShot(0, this, [this]() {
+        flush();
+    });
+}
+
+void FrameScheduler::flush()
+{
+    flushScheduled = false;
+    for (QHash<Display*, DisplayState>::iterator it = displayStates.begin(); it != displayStates.end(); ++it) {
+        DisplayState& state = it.value();
+        if (!state.dirty || state.frameInFlight || !it.key()->isVisible()) continue;
+        state.dirty = false;
+        state.frameInFlight = true;
+        it.key()->update();
+    }
+}
+
+void FrameScheduler::frameSwapped(Display* display)
+{
+    QHash<Display*, DisplayState>::iterator state = displayStates.find(display);
+    if (state == displayStates.end()) return;
+    state->frameInFlight = false;
+    if (state->dirty) scheduleFlush();
+}
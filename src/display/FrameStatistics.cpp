@@ -0,0 +1,196 @@
+/*                F R A M E S T A T I S T I C S . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file FrameStatistics.cpp */
+
+#include <algorithm>
+#include <QOpenGLTimerQuery>
+#include <QPainter>
+#include "FrameStatistics.h"
+
+
+FrameStatistics::FrameStatistics()
+{
+    Sample empty;
+    empty.frame = -1;
+    empty.cpuMs = -1;
+    empty.gpuMs = -1;
+    samples.fill(empty, sampleWindowSize);
+}
+
+FrameStatistics::~FrameStatistics()
+{
+    stopCsv();
+    for (QOpenGLTimerQuery* query : queries) delete query;
+}
+
+void FrameStatistics::releaseQueries()
+{
+    for (int i = 0; i < queryCount; i++) {
+        delete queries[i];
+        queries[i] = nullptr;
+        queryPending[i] = false;
+    }
+}
+
+FrameStatistics::Sample* FrameStatistics::findSample(qint64 sampleFrame)
+{
+    if (sampleFrame < 0) return nullptr;
+    Sample& sample = samples[sampleFrame % sampleWindowSize];
+    return sample.frame == sampleFrame ? &sample : nullptr;
+}
+
+void FrameStatistics::beginFrame()
+{
+    cpuTimer.start();
+
+    const int queryIndex = frame % queryCount;
+    if (!queriesSupported || queryPending[queryIndex]) return;
+    if (queries[queryIndex] == nullptr) {
+        queries[queryIndex] = new QOpenGLTimerQuery();
+        if (!queries[queryIndex]->create()) {
+            queriesSupported = false;
+            releaseQueries();
+            return;
+        }
+    }
+    queries[queryIndex]->begin();
+    queryPending[queryIndex] = true;
+    queryFrame[queryIndex] = frame;
+}
+
+void FrameStatistics::collectQueryResults()
+{
+    for (int i = 0; i < queryCount; i++) {
+        if (!queryPending[i] || queryFrame[i] == frame || !queries[i]->isResultAvailable()) continue;
+        queryPending[i] = false;
+        Sample* sample = findSample(queryFrame[i]);
+        if (sample != nullptr) sample->gpuMs = static_cast<double>(queries[i]->waitForResult()) / 1e6;
+    }
+}
+
+void FrameStatistics::endFrame(const Counters& counters)
+{
+    const int queryIndex = frame % queryCount;
+    if (queryPending[queryIndex] && queryFrame[queryIndex] == frame) queries[queryIndex]->end();
+
+    Sample& sample = samples[frame % sampleWindowSize];
+    sample.frame = frame;
+    sample.cpuMs = static_cast<double>(cpuTimer.nsecsElapsed()) / 1e6;
+    sample.gpuMs = -1;
+    sample.counters = counters;
+
+    collectQueryResults();
+
+    // by now the GPU time of this frame is either known or will never be
+    if (csvFile.isOpen()) {
+        const Sample* finishedSample = findSample(frame - queryCount);
+        if (finishedSample != nullptr) writeCsvLine(*finishedSample);
+    }
+
+    frame++;
+}
+
+double FrameStatistics::percentile(double Sample::*value, double percentile) const
+{
+    QVector<double> values;
+    values.reserve(sampleWindowSize);
+    for (const Sample& sample : samples) {
+        if (sample.frame >= 0 && sample.*value >= 0) values.append(sample.*value);
+    }
+    if (values.isEmpty()) return -1;
+
+    const int index = qBound(0, static_cast<int>(percentile / 100. * (values.size() - 1) + .5), values.size() - 1);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+double FrameStatistics::cpuPercentile(double percentile) const
+{
+    return this->percentile(&Sample::cpuMs, percentile);
+}
+
+double FrameStatistics::gpuPercentile(double percentile) const
+{
+    return this->percentile(&Sample::gpuMs, percentile);
+}
+
+void FrameStatistics::drawOverlay(QPainter& painter) const
+{
+    const Sample& last = samples[(frame + sampleWindowSize - 1) % sampleWindowSize];
+    if (last.frame < 0) return;
+
+    auto milliseconds = [](double value) {
+        return value < 0 ? QString("n/a") : QString::number(value, 'f', 2);
+    };
+
+    const QStringList lines = {
+        QString("CPU ms  p50 %1  p95 %2  p99 %3").arg(milliseconds(cpuPercentile(50)), milliseconds(cpuPercentile(95)),
+                                                      milliseconds(cpuPercentile(99))),
+        QString("GPU ms  p50 %1  p95 %2  p99 %3").arg(milliseconds(gpuPercentile(50)), milliseconds(gpuPercentile(95)),
+                                                      milliseconds(gpuPercentile(99))),
+        QString("Draw calls %1  Vertices %2").arg(last.counters.drawCalls).arg(last.counters.verticesSubmitted),
+        QString("Objects drawn %1  culled %2").arg(last.counters.objectsDrawn).arg(last.counters.objectsCulled),
+        QString("Plot queue %1").arg(last.counters.plotQueueDepth),
+    };
+
+    const QFontMetrics metrics = painter.fontMetrics();
+    int width = 0;
+    for (const QString& line : lines) width = qMax(width, metrics.horizontalAdvance(line));
+    const int margin = 6;
+    const QRect background(margin, margin, width + 2 * margin, lines.size() * metrics.height() + 2 * margin);
+
+    painter.fillRect(background, QColor(0, 0, 0, 160));
+    painter.setPen(Qt::white);
+    for (int i = 0; i < lines.size(); i++) {
+        painter.drawText(2 * margin, 2 * margin + i * metrics.height() + metrics.ascent(), lines[i]);
+    }
+}
+
+bool FrameStatistics::startCsv(const QString& filePath)
+{
+    stopCsv();
+    csvFile.setFileName(filePath);
+    if (!csvFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) return false;
+    csv.setDevice(&csvFile);
+    csv << "frame,cpu_ms,gpu_ms,draw_calls,vertices,objects_drawn,objects_culled,plot_queue\n";
+    return true;
+}
+
+void FrameStatistics::stopCsv()
+{
+    if (!csvFile.isOpen()) return;
+    // endFrame has written the frames before frame - queryCount
+    for (qint64 pendingFrame = qMax<qint64>(0, frame - queryCount); pendingFrame < frame; pendingFrame++) {
+        const Sample* sample = findSample(pendingFrame);
+        if (sample != nullptr) writeCsvLine(*sample);
+    }
+    csv.flush();
+    csv.setDevice(nullptr);
+    csvFile.close();
+}
+
+void FrameStatistics::writeCsvLine(const Sample& sample)
+{
+    csv << sample.frame << ',' << QString::number(sample.cpuMs, 'f', 3) << ','
+        << (sample.gpuMs < 0 ? QString() : QString::number(sample.gpuMs, 'f', 3)) << ','
+        << sample.counters.drawCalls << ',' << sample.counters.verticesSubmitted << ','
+        << sample.counters.objectsDrawn << ',' << sample.counters.objectsCulled << ','
+        << sample.counters.plotQueueDepth << '\n';
+}
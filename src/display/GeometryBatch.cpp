@@ -0,0 +1,358 @@
+/*                    G E O M E T R Y B A T C H . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file GeometryBatch.cpp */
+
+#include <QHash>
+#include "GeometryBatch.h"
+#include "DisplayManager.h"
+
+
+namespace {
+    // creates the buffer when needed. A buffer without data is destroyed instead
+    void uploadBuffer(QOpenGLBuffer& buffer, const void* data, int size)
+    {
+        if (size == 0) {
+            if (buffer.isCreated()) buffer.destroy();
+            return;
+        }
+        if (!buffer.isCreated()) buffer.create();
+        buffer.bind();
+        buffer.allocate(data, size);
+        buffer.release();
+    }
+
+    void drawIndexRange(GLenum mode, int firstIndex, int indexCount)
+    {
+        glDrawElements(mode, indexCount, GL_UNSIGNED_INT,
+                       reinterpret_cast<const GLvoid*>(static_cast<quintptr>(firstIndex) * sizeof(GLuint)));
+    }
+}
+
+
+GeometryBatch::GeometryBatch(const float color[3]) : vertexBuffer(QOpenGLBuffer::VertexBuffer),
+                                                     indexBuffer(QOpenGLBuffer::IndexBuffer),
+                                                     surfaceVertexBuffer(QOpenGLBuffer::VertexBuffer),
+                                                     surfaceIndexBuffer(QOpenGLBuffer::IndexBuffer)
+{
+    this->color[0] = color[0];
+    this->color[1] = color[1];
+    this->color[2] = color[2];
+    vertexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    indexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    surfaceVertexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    surfaceIndexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+}
+
+void GeometryBatch::addObject(int objectId, const PlotGeometry& geometry)
+{
+    removeObject(objectId);
+    objects[objectId] = geometry;
+    objectVertexCount += geometry.vertexCount() + geometry.surfaceVertexCount();
+    dirty = true;
+}
+
+void GeometryBatch::removeObject(int objectId)
+{
+    QMap<int, PlotGeometry>::iterator it = objects.find(objectId);
+    if (it == objects.end()) return;
+    objectVertexCount -= it.value().vertexCount() + it.value().surfaceVertexCount();
+    objects.erase(it);
+    dirty = true;
+}
+
+bool GeometryBatch::contains(int objectId) const
+{
+    return objects.contains(objectId);
+}
+
+bool GeometryBatch::isEmpty() const
+{
+    return objects.isEmpty();
+}
+
+bool GeometryBatch::isDirty() const
+{
+    return dirty;
+}
+
+int GeometryBatch::getVertexCount() const
+{
+    return vertexCount;
+}
+
+int GeometryBatch::getObjectVertexCount() const
+{
+    return objectVertexCount;
+}
+
+void GeometryBatch::destroyBuffers()
+{
+    // QOpenGLBuffer::destroy() needs the context the buffer was created in
+    if (vertexBuffer.isCreated()) vertexBuffer.destroy();
+    if (indexBuffer.isCreated()) indexBuffer.destroy();
+    if (surfaceVertexBuffer.isCreated()) surfaceVertexBuffer.destroy();
+    if (surfaceIndexBuffer.isCreated()) surfaceIndexBuffer.destroy();
+    vertexCount = 0;
+    objectRanges.clear();
+    visibleRanges.clear();
+    surfaceRanges.clear();
+    visibleSurfaceRanges.clear();
+    dirty = true;
+}
+
+void GeometryBatch::upload()
+{
+    if (!dirty) return;
+    dirty = false;
+
+    objectRanges.clear();
+    visibleRanges.clear();
+    surfaceRanges.clear();
+    visibleSurfaceRanges.clear();
+
+    // surfaces are independent of the wireframe buffers
+    QVector<GLfloat> surfaceVertices;
+    QVector<GLuint> surfaceIndices;
+    surfaceObjects = QBitArray(objects.isEmpty() ? 0 : objects.lastKey() + 1);
+    for (QMap<int, PlotGeometry>::const_iterator it = objects.constBegin(); it != objects.constEnd(); ++it) {
+        const PlotGeometry& geometry = it.value();
+        if (!geometry.hasSurface()) continue;
+        const GLuint baseVertex = static_cast<GLuint>(surfaceVertices.size() / 6);
+        surfaceRanges.append({it.key(), surfaceIndices.size(), geometry.surfaceIndices.size()});
+        for (GLuint index : geometry.surfaceIndices) surfaceIndices.append(index + baseVertex);
+        surfaceVertices.append(geometry.surfaceVertices);
+        surfaceObjects.setBit(it.key());
+    }
+    uploadBuffer(surfaceVertexBuffer, surfaceVertices.constData(), surfaceVertices.size() * static_cast<int>(sizeof(GLfloat)));
+    uploadBuffer(surfaceIndexBuffer, surfaceIndices.constData(), surfaceIndices.size() * static_cast<int>(sizeof(GLuint)));
+
+    // object ranges of each primitive, size and level, so each of them ends up contiguous in the index buffer
+    struct RangeKey {
+        GLenum mode;
+        float size;
+        int level;
+
+        bool operator<(const RangeKey& other) const
+        {
+            if (mode != other.mode) return mode < other.mode;
+            if (size != other.size) return size < other.size;
+            return level < other.level;
+        }
+    };
+    QMap<RangeKey, QVector<ObjectRange>> rangesByKey;
+    QVector<GLfloat> vertices;
+    int indexCount = 0;
+
+    for (QMap<int, PlotGeometry>::const_iterator it = objects.constBegin(); it != objects.constEnd(); ++it) {
+        const PlotGeometry& geometry = it.value();
+        const int lastLevel = geometry.levelCount() - 1;
+        for (int level = 0; level <= lastLevel; level++) {
+            for (const PlotGeometry::DrawRange& range : geometry.levelRanges(level)) {
+                rangesByKey[{range.mode, range.size, level}].append({it.key(), level, lastLevel, range});
+            }
+        }
+        vertices.append(geometry.vertices);
+        indexCount += geometry.indices.size();
+    }
+
+    vertexCount = vertices.size() / 3;
+    if (vertexCount == 0) {
+        if (vertexBuffer.isCreated()) vertexBuffer.destroy();
+        if (indexBuffer.isCreated()) indexBuffer.destroy();
+        return;
+    }
+
+    // first vertex of each object in the vertex buffer
+    QHash<int, GLuint> baseVertices;
+    GLuint baseVertex = 0;
+    for (QMap<int, PlotGeometry>::const_iterator it = objects.constBegin(); it != objects.constEnd(); ++it) {
+        baseVertices[it.key()] = baseVertex;
+        baseVertex += it.value().vertexCount();
+    }
+
+    QVector<GLuint> indices;
+    indices.reserve(indexCount);
+    for (const QVector<ObjectRange>& ranges : rangesByKey) {
+        for (const ObjectRange& objectRange : ranges) {
+            const PlotGeometry& geometry = objects[objectRange.objectId];
+            const GLuint objectBaseVertex = baseVertices[objectRange.objectId];
+
+            ObjectRange uploadedRange = objectRange;
+            uploadedRange.range.firstIndex = indices.size();
+            for (int i = 0; i < objectRange.range.indexCount; i++) {
+                indices.append(geometry.indices[objectRange.range.firstIndex + i] + objectBaseVertex);
+            }
+            objectRanges.append(uploadedRange);
+        }
+    }
+
+    uploadBuffer(vertexBuffer, vertices.constData(), vertices.size() * static_cast<int>(sizeof(GLfloat)));
+    uploadBuffer(indexBuffer, indices.constData(), indices.size() * static_cast<int>(sizeof(GLuint)));
+}
+
+bool GeometryBatch::hasSurface(int objectId) const
+{
+    return objectId < surfaceObjects.size() && surfaceObjects.testBit(objectId);
+}
+
+void GeometryBatch::updateVisibleRanges(const QBitArray& drawnObjects, const QVector<quint8>& objectLevels,
+                                        const bool shaded)
+{
+    visibleSurfaceRanges.clear();
+    if (shaded) {
+        for (const SurfaceRange& surfaceRange : surfaceRanges) {
+            if (surfaceRange.objectId >= drawnObjects.size() || !drawnObjects.testBit(surfaceRange.objectId)) continue;
+            if (!visibleSurfaceRanges.isEmpty()) {
+                SurfaceRange& last = visibleSurfaceRanges.last();
+                if (last.firstIndex + last.indexCount == surfaceRange.firstIndex) {
+                    last.indexCount += surfaceRange.indexCount;
+                    continue;
+                }
+            }
+            visibleSurfaceRanges.append(surfaceRange);
+        }
+    }
+
+    visibleRanges.clear();
+    for (const ObjectRange& objectRange : objectRanges) {
+        if (objectRange.objectId >= drawnObjects.size() || !drawnObjects.testBit(objectRange.objectId)) continue;
+        if (shaded && hasSurface(objectRange.objectId)) continue;
+        const int level = objectRange.objectId < objectLevels.size() ? objectLevels[objectRange.objectId] : 0;
+        if (objectRange.level != qMin(level, objectRange.lastLevel)) continue;
+
+        const PlotGeometry::DrawRange& range = objectRange.range;
+        if (!visibleRanges.isEmpty()) {
+            PlotGeometry::DrawRange& last = visibleRanges.last();
+            if (last.mode == range.mode && last.size == range.size &&
+                last.firstIndex + last.indexCount == range.firstIndex) {
+                last.indexCount += range.indexCount;
+                continue;
+            }
+        }
+        visibleRanges.append(range);
+    }
+}
+
+void GeometryBatch::draw(DisplayManager* displayManager, QOpenGLShaderProgram* surfaceProgram, int& drawCalls,
+                         int& indicesDrawn)
+{
+    if (!visibleSurfaceRanges.isEmpty() && surfaceProgram != nullptr && surfaceVertexBuffer.isCreated() &&
+        surfaceIndexBuffer.isCreated()) {
+        surfaceProgram->bind();
+        surfaceProgram->setUniformValue("color", color[0], color[1], color[2]);
+
+        surfaceVertexBuffer.bind();
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glVertexPointer(3, GL_FLOAT, 6 * sizeof(GLfloat), nullptr);
+        glNormalPointer(GL_FLOAT, 6 * sizeof(GLfloat), reinterpret_cast<const GLvoid*>(3 * sizeof(GLfloat)));
+        surfaceIndexBuffer.bind();
+
+        for (const SurfaceRange& range : visibleSurfaceRanges) {
+            drawIndexRange(GL_TRIANGLES, range.firstIndex, range.indexCount);
+            drawCalls++;
+            indicesDrawn += range.indexCount;
+        }
+
+        surfaceIndexBuffer.release();
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        surfaceVertexBuffer.release();
+        surfaceProgram->release();
+    }
+
+    if (visibleRanges.isEmpty() || !vertexBuffer.isCreated() || !indexBuffer.isCreated()) return;
+
+    displayManager->setFGColor(color[0], color[1], color[2], 1);
+    displayManager->applyWireMaterial();
+
+    GLfloat originalPointSize, originalLineWidth;
+    glGetFloatv(GL_POINT_SIZE, &originalPointSize);
+    glGetFloatv(GL_LINE_WIDTH, &originalLineWidth);
+
+    vertexBuffer.bind();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, nullptr);
+    indexBuffer.bind();
+
+    for (const PlotGeometry::DrawRange& range : visibleRanges) {
+        if (range.mode == GL_POINTS) glPointSize(range.size > 0 ? range.size : originalPointSize);
+        else glLineWidth(range.size > 0 ? range.size : originalLineWidth);
+
+        drawIndexRange(range.mode, range.firstIndex, range.indexCount);
+        drawCalls++;
+        indicesDrawn += range.indexCount;
+    }
+
+    indexBuffer.release();
+    glDisableClientState(GL_VERTEX_ARRAY);
+    vertexBuffer.release();
+
+    glPointSize(originalPointSize);
+    glLineWidth(originalLineWidth);
+}
+
+void GeometryBatch::drawObjectIds(const QBitArray& drawnObjects, const float lineWidth, const bool shaded)
+{
+    auto setIdColor = [](int objectId) {
+        const quint32 colorId = static_cast<quint32>(objectId) + 1;
+        glColor3ub((colorId >> 16) & 0xff, (colorId >> 8) & 0xff, colorId & 0xff);
+    };
+
+    if (shaded && !surfaceRanges.isEmpty() && surfaceVertexBuffer.isCreated() && surfaceIndexBuffer.isCreated()) {
+        surfaceVertexBuffer.bind();
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(3, GL_FLOAT, 6 * sizeof(GLfloat), nullptr);
+        surfaceIndexBuffer.bind();
+
+        for (const SurfaceRange& range : surfaceRanges) {
+            if (range.objectId >= drawnObjects.size() || !drawnObjects.testBit(range.objectId)) continue;
+            setIdColor(range.objectId);
+            drawIndexRange(GL_TRIANGLES, range.firstIndex, range.indexCount);
+        }
+
+        surfaceIndexBuffer.release();
+        glDisableClientState(GL_VERTEX_ARRAY);
+        surfaceVertexBuffer.release();
+    }
+
+    if (objectRanges.isEmpty() || !vertexBuffer.isCreated() || !indexBuffer.isCreated()) return;
+
+    vertexBuffer.bind();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, nullptr);
+    indexBuffer.bind();
+
+    for (const ObjectRange& objectRange : objectRanges) {
+        if (objectRange.level != 0) continue;
+        if (objectRange.objectId >= drawnObjects.size() || !drawnObjects.testBit(objectRange.objectId)) continue;
+        if (shaded && hasSurface(objectRange.objectId)) continue;
+        setIdColor(objectRange.objectId);
+
+        const PlotGeometry::DrawRange& range = objectRange.range;
+        if (range.mode == GL_POINTS) glPointSize(qMax(range.size, lineWidth));
+        else glLineWidth(qMax(range.size, lineWidth));
+        drawIndexRange(range.mode, range.firstIndex, range.indexCount);
+    }
+
+    indexBuffer.release();
+    glDisableClientState(GL_VERTEX_ARRAY);
+    vertexBuffer.release();
+}
@@ -0,0 +1,268 @@
+/*                   G E O M E T R Y P L O T T E R . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file GeometryPlotter.cpp */
+
+#include <cstring>
+#include <QRunnable>
+#include <QStringList>
+#include <QThread>
+#include <brlcad/Combination.h>
+#include <brlcad/Database/ConstDatabase.h>
+#include "GeometryPlotter.h"
+#include "Utils.h"
+
+
+class PlotTask : public QRunnable {
+public:
+    PlotTask(GeometryPlotter* plotter, int objectId, const QString& fullPath, quint64 generation, bool transformOnly) :
+        plotter(plotter), objectId(objectId), fullPath(fullPath), generation(generation), transformOnly(transformOnly) {}
+
+    void run() override
+    {
+        if (transformOnly) plotter->computeTransform(objectId, fullPath, generation);
+        else plotter->plot(objectId, fullPath, generation);
+    }
+
+private:
+    GeometryPlotter* plotter;
+    int objectId;
+    QString fullPath;
+    quint64 generation;
+    bool transformOnly;
+};
+
+namespace {
+    // copies the matrix of the first leaf named childName out of the combination
+    class LeafMatrixCallback : public BRLCAD::ConstDatabase::ObjectCallback {
+    public:
+        explicit LeafMatrixCallback(const QString& childName) : childName(childName) {}
+
+        void operator()(const BRLCAD::Object& object) override
+        {
+            const BRLCAD::Combination* combination = dynamic_cast<const BRLCAD::Combination*>(&object);
+            if (combination == nullptr) return;
+            BRLCAD::Combination::ConstTreeNode tree = combination->Tree();
+            const double* leafMatrix = getLeafMatrix(tree, childName);
+            if (leafMatrix != nullptr) memcpy(elements, leafMatrix, sizeof(elements));
+        }
+
+        // BRL-CAD matrices are row-major like the QMatrix4x4 constructor expects
+        QMatrix4x4 matrix() const
+        {
+            return QMatrix4x4(elements[0], elements[1], elements[2], elements[3],
+                              elements[4], elements[5], elements[6], elements[7],
+                              elements[8], elements[9], elements[10], elements[11],
+                              elements[12], elements[13], elements[14], elements[15]);
+        }
+
+        double elements[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+    private:
+        QString childName;
+    };
+
+    // the leaf matrices along the path, as they are stored. The caller holds the database mutex
+    QByteArray pathMatrices(BRLCAD::ConstDatabase* database, const QStringList& names)
+    {
+        QByteArray matrices;
+        for (int i = 0; i + 1 < names.size(); i++) {
+            LeafMatrixCallback callback(names[i + 1]);
+            database->Get(names[i].toUtf8(), callback);
+            matrices.append(reinterpret_cast<const char*>(callback.elements), sizeof(callback.elements));
+        }
+        return matrices;
+    }
+}
+
+
+GeometryPlotter::GeometryPlotter(BRLCAD::ConstDatabase* database) : database(database)
+{
+    threadPool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+GeometryPlotter::~GeometryPlotter()
+{
+    cancelAll();
+    threadPool.clear();
+    threadPool.waitForDone();
+}
+
+quint64 GeometryPlotter::startRequest(int objectId)
+{
+    QMutexLocker locker(&mutex);
+    if (pendingGenerations.contains(objectId)) return 0;
+    const quint64 generation = nextGeneration++;
+    pendingGenerations[objectId] = generation;
+    return generation;
+}
+
+void GeometryPlotter::request(int objectId, const QString& fullPath)
+{
+    const quint64 generation = startRequest(objectId);
+    if (generation != 0) threadPool.start(new PlotTask(this, objectId, fullPath, generation, false));
+}
+
+void GeometryPlotter::requestTransform(int objectId, const QString& fullPath)
+{
+    const quint64 generation = startRequest(objectId);
+    if (generation != 0) threadPool.start(new PlotTask(this, objectId, fullPath, generation, true));
+}
+
+void GeometryPlotter::cancel(int objectId)
+{
+    QMutexLocker locker(&mutex);
+    pendingGenerations.remove(objectId);
+    for (int i = finished.size() - 1; i >= 0; i--) {
+        if (finished[i].objectId == objectId) finished.removeAt(i);
+    }
+}
+
+void GeometryPlotter::cancelAll()
+{
+    threadPool.clear();
+    QMutexLocker locker(&mutex);
+    pendingGenerations.clear();
+    finished.clear();
+}
+
+bool GeometryPlotter::isPending(int objectId) const
+{
+    QMutexLocker locker(&mutex);
+    return pendingGenerations.contains(objectId);
+}
+
+int GeometryPlotter::getPendingCount() const
+{
+    QMutexLocker locker(&mutex);
+    return pendingGenerations.size();
+}
+
+bool GeometryPlotter::hasFinished() const
+{
+    QMutexLocker locker(&mutex);
+    return !finished.isEmpty();
+}
+
+QVector<GeometryPlotter::Result> GeometryPlotter::takeFinished(int maxCount)
+{
+    QMutexLocker locker(&mutex);
+    QVector<Result> results;
+    const int count = qMin(maxCount, finished.size());
+    results.reserve(count);
+    for (int i = 0; i < count; i++) {
+        pendingGenerations.remove(finished[i].objectId);
+        results.append(std::move(finished[i]));
+    }
+    finished.remove(0, count);
+    return results;
+}
+
+QMutex* GeometryPlotter::getDatabaseMutex()
+{
+    return &databaseMutex;
+}
+
+void GeometryPlotter::setCache(PlotCache* cache)
+{
+    this->cache = cache;
+}
+
+void GeometryPlotter::plot(int objectId, const QString& fullPath, quint64 generation)
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (pendingGenerations.value(objectId) != generation) return;
+    }
+
+    Result result;
+    result.objectId = objectId;
+
+    // cached geometry is found by the object's record in the .g file and the matrices along the path
+    const QStringList names = fullPath.split('/', QString::SkipEmptyParts);
+    QByteArray matrices;
+    QByteArray key;
+    if (cache != nullptr && !names.isEmpty()) {
+        {
+            QMutexLocker locker(&databaseMutex);
+            matrices = pathMatrices(database, names);
+        }
+        key = cache->objectKey(names.last(), matrices);
+    }
+
+    if (key.isEmpty() || !cache->find(key, result.geometry)) {
+        // vector list elements are allocated from and freed to librt's global free list
+        BRLCAD::VectorList* vectorList;
+        {
+            QMutexLocker locker(&databaseMutex);
+            // a matrix edited since the key was made would store this plot under the old key
+            if (!key.isEmpty() && pathMatrices(database, names) != matrices) key.clear();
+            vectorList = new BRLCAD::VectorList();
+            database->Plot(fullPath.toUtf8(), *vectorList);
+        }
+
+        result.geometry = PlotGeometry::fromVectorList(*vectorList);
+
+        {
+            QMutexLocker locker(&databaseMutex);
+            delete vectorList;
+        }
+
+        if (!key.isEmpty()) cache->insert(key, names.last(), result.geometry);
+    }
+    result.geometry.generateLevels();
+    finish(std::move(result), generation);
+}
+
+void GeometryPlotter::computeTransform(int objectId, const QString& fullPath, quint64 generation)
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (pendingGenerations.value(objectId) != generation) return;
+    }
+
+    Result result;
+    result.objectId = objectId;
+    result.isTransform = true;
+
+    // each combination's matrix applies to the member that follows it in the path
+    const QStringList names = fullPath.split('/', QString::SkipEmptyParts);
+    {
+        QMutexLocker locker(&databaseMutex);
+        for (int i = 0; i + 1 < names.size(); i++) {
+            LeafMatrixCallback callback(names[i + 1]);
+            database->Get(names[i].toUtf8(), callback);
+            result.transform *= callback.matrix();
+        }
+    }
+
+    finish(std::move(result), generation);
+}
+
+void GeometryPlotter::finish(Result&& result, quint64 generation)
+{
+    bool notify;
+    {
+        QMutexLocker locker(&mutex);
+        if (pendingGenerations.value(result.objectId) != generation) return;
+        notify = finished.isEmpty();
+        finished.append(std::move(result));
+    }
+    if (notify) emit objectsReady();
+}
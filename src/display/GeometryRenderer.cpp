@@ -19,82 +19,445 @@
  */
  /** @file GeometryRenderer.cpp */
 
+#include <QElapsedTimer>
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+#include <QTimer>
 #include "GeometryRenderer.h"
+#include "DisplayGrid.h"
+#include "OrthographicCamera.h"
+
+namespace {
+    const char* surfaceVertexShader = R"(
+        #version 120
+        uniform vec3 color;
+        varying vec3 eyeNormal;
+        varying vec3 surfaceColor;
+
+        void main() {
+            eyeNormal = gl_NormalMatrix * gl_Normal;
+            surfaceColor = color;
+            gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+        }
+    )";
+
+    // combination matrices only rotate, translate and scale uniformly, so their upper 3x3 can transform normals
+    const char* instancedSurfaceVertexShader = R"(
+        #version 120
+        attribute mat4 instanceMatrix;
+        attribute vec3 instanceColor;
+        varying vec3 eyeNormal;
+        varying vec3 surfaceColor;
+
+        void main() {
+            mat3 instanceRotation = mat3(instanceMatrix[0].xyz, instanceMatrix[1].xyz, instanceMatrix[2].xyz);
+            eyeNormal = gl_NormalMatrix * (instanceRotation * gl_Normal);
+            surfaceColor = instanceColor;
+            gl_Position = gl_ModelViewProjectionMatrix * (instanceMatrix * gl_Vertex);
+        }
+    )";
+
+    // Phong shading with a light at the camera. Both sides are lit, since plots do not have consistent windings
+    const char* surfaceFragmentShader = R"(
+        #version 120
+        varying vec3 eyeNormal;
+        varying vec3 surfaceColor;
+
+        void main() {
+            vec3 normal = normalize(eyeNormal);
+            vec3 toLight = vec3(0.0, 0.0, 1.0);
+            float diffuse = abs(dot(normal, toLight));
+            vec3 reflected = reflect(-toLight, normal);
+            float specular = pow(max(reflected.z, 0.0), 32.0);
+            gl_FragColor = vec4(surfaceColor * (0.25 + 0.75 * diffuse) + vec3(0.3 * specular), 1.0);
+        }
+    )";
+
+    const char* instancedWireVertexShader = R"(
+        #version 120
+        attribute mat4 instanceMatrix;
+        attribute vec3 instanceColor;
+        varying vec3 wireColor;
+
+        void main() {
+            wireColor = instanceColor;
+            gl_Position = gl_ModelViewProjectionMatrix * (instanceMatrix * gl_Vertex);
+        }
+    )";
+
+    const char* instancedWireFragmentShader = R"(
+        #version 120
+        varying vec3 wireColor;
+
+        void main() {
+            gl_FragColor = vec4(wireColor, 1.0);
+        }
+    )";
+
+    QOpenGLShaderProgram* createProgram(const char* vertexShader, const char* fragmentShader)
+    {
+        QOpenGLShaderProgram* program = new QOpenGLShaderProgram();
+        if (!program->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader) ||
+            !program->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader) ||
+            !program->link()) {
+            qWarning("GeometryRenderer: %s", qPrintable(program->log()));
+            delete program;
+            return nullptr;
+        }
+        return program;
+    }
+}
 
 
 GeometryRenderer::GeometryRenderer(Document* document) : document(document)
 {
+    plotter = new GeometryPlotter(document->getDatabase());
+    if (document->getFilePath() != nullptr) {
+        plotCache = new PlotCache(*document->getFilePath());
+        if (plotCache->isValid()) {
+            plotCache->load();
+            plotter->setCache(plotCache);
+        }
+    }
+    QObject::connect(plotter, &GeometryPlotter::objectsReady, plotter, [this]() {
+        this->document->getDisplayGrid()->forceRerenderAllDisplays();
+    }, Qt::QueuedConnection);
+
     refreshForVisibilityAndSolidChanges();
 }
 
+GeometryRenderer::~GeometryRenderer() {
+    delete surfaceProgram;
+    delete instancedWireProgram;
+    delete instancedSurfaceProgram;
+    delete plotter;
+    if (plotCache != nullptr) {
+        plotCache->save();
+        delete plotCache;
+    }
+    for (const QVector<GeometryBatch*>& batches : colorBatches) qDeleteAll(batches);
+    qDeleteAll(instancedSolids);
+}
+
 void GeometryRenderer::render() {
-    document->getDisplay()->getDisplayManager()->saveState();
+    render(document->getDisplay());
+}
+
+void GeometryRenderer::render(Display* display) {
+    if (!QOpenGLContext::areSharing(QOpenGLContext::currentContext(), QOpenGLContext::globalShareContext())) {
+        qWarning("GeometryRenderer: current OpenGL context does not share resources with the global share context");
+        return;
+    }
+
     if (!objectsToBeDisplayedIds.empty()) {
         for (int objectId : objectsToBeDisplayedIds) {
-            if (!objectIdDisplayListIdMap.contains(objectId)) {
-                drawSolid(objectId);
+            if (objectIdBatchMap.contains(objectId) || objectIdSolidMap.contains(objectId)) continue;
+            const QString& fullPath = document->getObjectTree()->getFullPathMap()[objectId];
+            if (!isInstanced(objectId)) {
+                plotter->request(objectId, fullPath);
+                continue;
+            }
+
+            const QString& solidName = document->getObjectTree()->getNameMap()[objectId];
+            const int index = solidIndex(solidName);
+            if (!instancedSolids.contains(index) || !instancedSolids[index]->hasGeometry()) {
+                plotter->request(solidPlotId(index), "/" + solidName);
             }
-            visibleDisplayListIds.append(objectIdDisplayListIdMap[objectId]);
+            plotter->requestTransform(objectId, fullPath);
         }
         objectsToBeDisplayedIds.clear();
     }
 
-    for (int displayListId : visibleDisplayListIds) {
-        document->getDisplay()->getDisplayManager()->drawDList(displayListId);
+    // add whatever the workers finished, as long as the frame budget allows
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < uploadTimeBudgetMs) {
+        const QVector<GeometryPlotter::Result> results = plotter->takeFinished(32);
+        if (results.isEmpty()) break;
+        for (const GeometryPlotter::Result& result : results) {
+            if (result.objectId < 0) setSolidGeometry(-1 - result.objectId, result.geometry);
+            else if (result.isTransform) addInstance(result.objectId, result.transform);
+            else addPlottedGeometry(result.objectId, result.geometry);
+        }
+    }
+    if (plotter->hasFinished()) {
+        QTimer::singleShot(0, plotter, [this]() {
+            document->getDisplayGrid()->forceRerenderAllDisplays();
+        });
+    }
+
+    const QBitArray drawnObjects = objectsInView(display);
+    drawnObjectCount = drawnObjects.count(true);
+    culledObjectCount = (visibleObjects & plottedObjects).count(true) - drawnObjectCount;
+    const QVector<quint8>& objectLevels = updateLevelsOfDetail(display, drawnObjects);
+
+    if (!programsCreated) createPrograms();
+    const bool shaded = display->shadedModeEnabled && surfaceProgram != nullptr;
+
+    drawCallCount = 0;
+    submittedVertexCount = 0;
+    DisplayManager* displayManager = display->getDisplayManager();
+    displayManager->saveState();
+    if (shaded) {
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LEQUAL);
+    }
+    for (QHash<quint32, QVector<GeometryBatch*>>::iterator it = colorBatches.begin(); it != colorBatches.end(); ++it) {
+        QVector<GeometryBatch*>& batches = it.value();
+        for (int i = batches.size() - 1; i >= 0; i--) {
+            if (!batches[i]->isEmpty()) continue;
+            batches[i]->destroyBuffers();
+            delete batches[i];
+            batches.removeAt(i);
+        }
+
+        for (GeometryBatch* batch : batches) {
+            batch->upload();
+            batch->updateVisibleRanges(drawnObjects, objectLevels, shaded);
+            batch->draw(displayManager, surfaceProgram, drawCallCount, submittedVertexCount);
+        }
+    }
+
+    const InstancedGeometry::Programs programs = {surfaceProgram, instancedWireProgram, instancedSurfaceProgram};
+    for (InstancedGeometry* solid : instancedSolids) {
+        solid->upload();
+        solid->draw(displayManager, programs, drawnObjects, objectLevels, shaded, drawCallCount, submittedVertexCount);
     }
-    document->getDisplay()->getDisplayManager()->restoreState();
+
+    displayManager->restoreState();
 }
 
+void GeometryRenderer::renderObjectIds(Display* display, const float lineWidth) {
+    if (!QOpenGLContext::areSharing(QOpenGLContext::currentContext(), QOpenGLContext::globalShareContext())) return;
 
-void GeometryRenderer::drawSolid(int objectId) {
-    const ColorInfo colorInfo = document->getObjectTree()->getColorMap()[objectId];
-    const QString objectFullPath = document->getObjectTree()->getFullPathMap()[objectId];
-    BRLCAD::VectorList vectorList;
-    document->getDatabase()->Plot(objectFullPath.toUtf8(), vectorList);
+    const QBitArray drawnObjects = objectsInView(display);
+    const bool shaded = display->shadedModeEnabled && surfaceProgram != nullptr;
+    for (const QVector<GeometryBatch*>& batches : colorBatches) {
+        for (GeometryBatch* batch : batches) {
+            batch->upload();
+            batch->drawObjectIds(drawnObjects, lineWidth, shaded);
+        }
+    }
+    for (InstancedGeometry* solid : instancedSolids) {
+        solid->upload();
+        solid->drawObjectIds(drawnObjects, lineWidth, shaded);
+    }
+}
+
+void GeometryRenderer::createPrograms() {
+    programsCreated = true;
+    surfaceProgram = createProgram(surfaceVertexShader, surfaceFragmentShader);
+    instancedWireProgram = createProgram(instancedWireVertexShader, instancedWireFragmentShader);
+    instancedSurfaceProgram = createProgram(instancedSurfaceVertexShader, surfaceFragmentShader);
+}
 
-    clearSolidIfAvailable(objectId);
+// objects that are visible and in the view frustum of the display
+QBitArray GeometryRenderer::objectsInView(const Display* display) {
+    updateBoundingVolumeHierarchy();
+    const OrthographicCamera* camera = display->getCamera();
+    const ViewFrustum frustum(camera->projectionMatrix() * camera->modelViewMatrix());
+    QBitArray objects(visibleObjects.size());
+    boundingVolumeHierarchy.query(frustum, objects);
+    for (int objectId : unindexedObjectIds) {
+        if (objectId < objects.size() && frustum.intersect(objectBounds.value(objectId)) != ViewFrustum::Outside) {
+            objects.setBit(objectId);
+        }
+    }
+    objects &= visibleObjects;
+    return objects;
+}
 
-    const unsigned int displayListId = document->getDisplay()->getDisplayManager()->genDLists(1);
-    document->getDisplay()->getDisplayManager()->beginDList(displayListId);  // begin display list --------------
 
+void GeometryRenderer::objectColor(int objectId, float color[3]) const {
+    const ColorInfo colorInfo = document->getObjectTree()->getColorMap()[objectId];
     if (colorInfo.hasColor) {
-        document->getDisplay()->getDisplayManager()->setFGColor(colorInfo.red, colorInfo.green, colorInfo.blue, 1);
+        color[0] = colorInfo.red;
+        color[1] = colorInfo.green;
+        color[2] = colorInfo.blue;
     }
     else {
-        document->getDisplay()->getDisplayManager()->setFGColor(defaultWireColor[0], defaultWireColor[1], defaultWireColor[2], 1);
+        color[0] = defaultWireColor[0];
+        color[1] = defaultWireColor[1];
+        color[2] = defaultWireColor[2];
     }
+}
+
+void GeometryRenderer::addPlottedGeometry(int objectId, const PlotGeometry& geometry) {
+    removePlottedGeometry(objectId);
+
+    float color[3];
+    objectColor(objectId, color);
 
     //displayManager->setLineStyle(tsp->ts_sofar & (TS_SOFAR_MINUS | TS_SOFAR_INTER));
-    document->getDisplay()->getDisplayManager()->drawVList(&vectorList);
-    document->getDisplay()->getDisplayManager()->endDList();     // end display list --------------
+    QVector<GeometryBatch*>& batches = colorBatches[batchKey(color)];
+    if (batches.isEmpty() || batches.last()->getObjectVertexCount() >= maxBatchVertexCount) {
+        batches.append(new GeometryBatch(color));
+    }
+    batches.last()->addObject(objectId, geometry);
+
+    objectIdBatchMap[objectId] = batches.last();
+    objectBounds[objectId] = geometry.bounds;
+    unindexedObjectIds.append(objectId);
+    if (plottedObjects.size() <= objectId) plottedObjects.resize(objectId + 1);
+    plottedObjects.setBit(objectId);
+    revision++;
+}
+
+void GeometryRenderer::removePlottedGeometry(int objectId) {
+    if (objectIdBatchMap.contains(objectId)) objectIdBatchMap.take(objectId)->removeObject(objectId);
+    else if (objectIdSolidMap.contains(objectId)) instancedSolids[objectIdSolidMap.take(objectId)]->removeInstance(objectId);
+    else return;
+
+    objectBounds.remove(objectId);
+    if (objectId < plottedObjects.size()) plottedObjects.clearBit(objectId);
+    boundingVolumeHierarchyDirty = true;
+    revision++;
+}
+
+void GeometryRenderer::updateSolidUseCounts() {
+    const QSet<int>& drawableObjectIds = document->getObjectTree()->getDrawableObjectIds();
+    if (drawableObjectIds.size() == solidUseCountsObjectCount) return;
+    solidUseCountsObjectCount = drawableObjectIds.size();
+
+    solidUseCounts.clear();
+    const QHash<int, QString>& nameMap = document->getObjectTree()->getNameMap();
+    for (int objectId : drawableObjectIds) solidUseCounts[nameMap.value(objectId)]++;
+}
+
+bool GeometryRenderer::isInstanced(int objectId) const {
+    return solidUseCounts.value(document->getObjectTree()->getNameMap().value(objectId)) >= instancingThreshold;
+}
 
-    objectIdDisplayListIdMap[objectId] = displayListId;
+int GeometryRenderer::solidIndex(const QString& solidName) {
+    QHash<QString, int>::const_iterator it = solidIndices.constFind(solidName);
+    if (it != solidIndices.constEnd()) return it.value();
+    solidNames.append(solidName);
+    solidIndices[solidName] = solidNames.size() - 1;
+    return solidNames.size() - 1;
+}
+
+// the geometry was plotted for the first time or again after the solid was modified
+void GeometryRenderer::setSolidGeometry(int solidIndex, const PlotGeometry& geometry) {
+    InstancedGeometry*& solid = instancedSolids[solidIndex];
+    if (solid == nullptr) solid = new InstancedGeometry();
+    solid->setGeometry(geometry);
+    for (int objectId : solid->getInstanceIds()) updateInstanceBounds(objectId, solid);
+    boundingVolumeHierarchyDirty = true;
+    revision++;
+}
+
+// instances whose transform arrives before the solid's geometry are drawn once the geometry is set
+void GeometryRenderer::addInstance(int objectId, const QMatrix4x4& transform) {
+    removePlottedGeometry(objectId);
+
+    const int index = solidIndex(document->getObjectTree()->getNameMap()[objectId]);
+    InstancedGeometry*& solid = instancedSolids[index];
+    if (solid == nullptr) solid = new InstancedGeometry();
+
+    float color[3];
+    objectColor(objectId, color);
+    solid->addInstance(objectId, transform, color);
+    objectIdSolidMap[objectId] = index;
+    updateInstanceBounds(objectId, solid);
+    revision++;
+}
+
+void GeometryRenderer::updateInstanceBounds(int objectId, const InstancedGeometry* solid) {
+    if (!solid->hasGeometry()) return;
+    objectBounds[objectId] = solid->getGeometry().bounds.transformed(solid->getTransform(objectId));
+    unindexedObjectIds.append(objectId);
+    if (plottedObjects.size() <= objectId) plottedObjects.resize(objectId + 1);
+    plottedObjects.setBit(objectId);
+}
+
+/*
+ * Picks the level of detail of each drawn object from the height of its bounding box diagonal on the display. Level i
+ * is meant for objects smaller than levelPixelSizes[i - 1]. An object only changes level when it is hysteresis
+ * beyond the limit, so objects whose size is right at a limit do not keep switching.
+ */
+const QVector<quint8>& GeometryRenderer::updateLevelsOfDetail(const Display* display, const QBitArray& drawnObjects) {
+    static const float levelPixelSizes[PlotGeometry::maxLevelCount - 1] = {256.f, 64.f, 16.f};
+
+    QVector<quint8>& levels = displayObjectLevels[display];
+    if (levels.size() < drawnObjects.size()) levels.resize(drawnObjects.size());
+
+    const float pixelsPerUnit = static_cast<float>(display->getH() / display->getCamera()->getVerticalSpan());
+    for (int objectId = 0; objectId < drawnObjects.size(); objectId++) {
+        if (!drawnObjects.testBit(objectId)) continue;
+        const float pixels = objectBounds.value(objectId).size().length() * pixelsPerUnit;
+
+        int level = levels[objectId];
+        while (level > 0 && pixels > levelPixelSizes[level - 1] * (1.f + levelHysteresis)) level--;
+        while (level < PlotGeometry::maxLevelCount - 1 && pixels < levelPixelSizes[level] * (1.f - levelHysteresis)) level++;
+        levels[objectId] = static_cast<quint8>(level);
+    }
+    return levels;
+}
+
+/*
+ * Newly plotted objects are tested one by one until the hierarchy is rebuilt. Rebuilding when their number reaches the
+ * size of the hierarchy keeps the total rebuild cost at O(n log n) while a model is being plotted.
+ */
+void GeometryRenderer::updateBoundingVolumeHierarchy() {
+    if (!boundingVolumeHierarchyDirty) {
+        if (unindexedObjectIds.isEmpty()) return;
+        const bool plottingFinished = plotter->getPendingCount() == 0;
+        if (!plottingFinished && unindexedObjectIds.size() < qMax(256, boundingVolumeHierarchy.size())) return;
+    }
+
+    QVector<BoundingVolumeHierarchy::Item> items;
+    items.reserve(objectBounds.size());
+    for (QHash<int, AxisAlignedBox>::const_iterator it = objectBounds.constBegin(); it != objectBounds.constEnd(); ++it) {
+        items.append({it.key(), it.value()});
+    }
+    boundingVolumeHierarchy.build(items);
+    unindexedObjectIds.clear();
+    boundingVolumeHierarchyDirty = false;
+}
+
+quint32 GeometryRenderer::batchKey(const float color[3]) const {
+    quint32 key = 0;
+    for (int i = 0; i < 3; i++) {
+        const float component = color[i] < 0.f ? 0.f : (color[i] > 1.f ? 1.f : color[i]);
+        key = (key << 8) | static_cast<quint32>(component * 255.f + .5f);
+    }
+    return key;
 }
 
 
 
 void GeometryRenderer::refreshForVisibilityAndSolidChanges() {
-    visibleDisplayListIds.clear();
-    document->getObjectTree()->traverseSubTree(0, false,[this]
+    updateSolidUseCounts();
+    visibleObjects = QBitArray(document->getObjectTree()->getColorMap().size());
+    document->getObjectTree()->traverse(0, false,[this]
         (int objectId)
         {
             if (document->getObjectTree()->getObjectVisibility()[objectId] == ObjectTree::Invisible) return false;
             if (!document->getObjectTree()->getDrawableObjectIds().contains(objectId)) return true;
             objectsToBeDisplayedIds.append(objectId);
+            visibleObjects.setBit(objectId);
             return true;
         }
     );
+    revision++;
 }
 
+// Buffers of the batch are updated on the next render, when there is a current context
 void GeometryRenderer::clearSolidIfAvailable(int objectId) {
-    if (objectIdDisplayListIdMap.contains(objectId)){
-        document->getDisplay()->getDisplayManager()->freeDLists(objectIdDisplayListIdMap[objectId], 1);
-        objectIdDisplayListIdMap.remove(objectId);
-    }
+    plotter->cancel(objectId);
+    removePlottedGeometry(objectId);
+
+    // The shared geometry is plotted again, as it can not be told whether the solid or a matrix above it changed.
+    // Its other instances keep being drawn with the old geometry until then
+    const QString& name = document->getObjectTree()->getNameMap()[objectId];
+    QHash<QString, int>::const_iterator it = solidIndices.constFind(name);
+    if (it == solidIndices.constEnd()) return;
+    plotter->cancel(solidPlotId(it.value()));
+    plotter->request(solidPlotId(it.value()), "/" + name);
 }
 
 void GeometryRenderer::clearObject(int objectId) {
-    document->getObjectTree()->traverseSubTree(objectId, true, [this](int objectId){
+    document->getObjectTree()->traverse(objectId, true, [this](int objectId){
         clearSolidIfAvailable(objectId);
         return true;
     });
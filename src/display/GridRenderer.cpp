@@ -7,44 +7,137 @@
 
 #include <GL/gl.h>
 #include <cmath>
-#include <iostream>
+#include <QOpenGLShaderProgram>
 #include "AxesRenderer.h"
 
-void GridRenderer::render() {
-    //todo implement line drawing in DisplayManager and use it instead of calling OpenGL here
+namespace {
+    const char* gridVertexShader = R"(
+        #version 120
+        attribute vec3 position;        // normalized device coordinates, z is the depth of the plane
+        attribute vec2 planePosition;   // plane coordinates relative to the grid origin
+        varying vec2 planeCoordinate;
 
-    int lineCount = 1000;
-    double lineGap;
-    lineGap = .1 * std::pow(2.71,int(std::log(display->getCamera()->getVerticalSpan())));
+        void main() {
+            planeCoordinate = planePosition;
+            gl_Position = vec4(position, 1.0);
+        }
+    )";
 
-    float length = lineCount*lineGap;
-    float lineColor[] = {.3,.3,.3};
+    const char* gridFragmentShader = R"(
+        #version 120
+        uniform vec3 lineColor;
+        uniform float alpha;
+        uniform float spacing;          // spacing of the finest level
+        uniform float fineLevelWeight;  // the finest level fades out as its lines get closer on the screen
+        varying vec2 planeCoordinate;
 
-    display->getDisplayManager()->saveState();
+        // 1 on a line, falling to 0 one pixel away from it
+        float lineCoverage(float levelSpacing) {
+            vec2 cell = planeCoordinate / levelSpacing;
+            vec2 pixelsPerCell = fwidth(cell);
+            vec2 distanceToLine = abs(fract(cell - 0.5) - 0.5) / max(pixelsPerCell, vec2(1e-6));
+            return 1.0 - min(min(distanceToLine.x, distanceToLine.y), 1.0);
+        }
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        void main() {
+            float coverage = max(lineCoverage(spacing) * fineLevelWeight, lineCoverage(spacing * 10.0));
+            if (coverage <= 0.0) discard;
+            gl_FragColor = vec4(lineColor, alpha * coverage);
+        }
+    )";
+}
+
+GridRenderer::GridRenderer(Display *display) : display(display) {}
+
+GridRenderer::~GridRenderer() {
+    delete program;
+}
+
+bool GridRenderer::createProgram() {
+    program = new QOpenGLShaderProgram();
+    if (!program->addShaderFromSourceCode(QOpenGLShader::Vertex, gridVertexShader) ||
+        !program->addShaderFromSourceCode(QOpenGLShader::Fragment, gridFragmentShader) ||
+        !program->link()) {
+        qWarning("GridRenderer: %s", qPrintable(program->log()));
+        delete program;
+        program = nullptr;
+        programFailed = true;
+        return false;
+    }
+    return true;
+}
+
+void GridRenderer::render() {
+    if (program == nullptr && (programFailed || !createProgram())) return;
+
+    OrthographicCamera* camera = display->getCamera();
+    bool invertible = false;
+    const QMatrix4x4 inverseViewProjection = (camera->projectionMatrix() * camera->modelViewMatrix()).inverted(&invertible);
+    if (!invertible) return;
 
-    float alpha = sqrt(abs(std::fmod(abs(display->getCamera()->getAnglesAroundAxes()[0]),180)-90)/90.)*.7;
-    if (abs(std::fmod(abs(display->getCamera()->getAnglesAroundAxes()[0]),180)-90)<4) {
-        alpha = (abs(std::fmod(abs(display->getCamera()->getAnglesAroundAxes()[0]),180)-90)/90.)*.7;
+    float alpha = sqrt(abs(std::fmod(abs(camera->getAnglesAroundAxes()[0]),180)-90)/90.)*.7;
+    if (abs(std::fmod(abs(camera->getAnglesAroundAxes()[0]),180)-90)<4) {
+        alpha = (abs(std::fmod(abs(camera->getAnglesAroundAxes()[0]),180)-90)/90.)*.7;
     }
 
-    glColor4f(lineColor[0],lineColor[1],lineColor[2],alpha);
-    glBegin(GL_LINES);
-    for (double i = -lineCount*lineGap/2; i < lineCount*lineGap/2; i+=lineGap){
-        glVertex3f(i, length / 2, 0);
-        glVertex3f(i, -length / 2, 0);
+    // finest spacing that keeps the lines minimumLineSpacing pixels apart, and how far it is from the next level
+    const double unitsPerPixel = camera->getVerticalSpan() / display->getH();
+    const double level = std::log10(unitsPerPixel * minimumLineSpacing);
+    const double spacing = std::pow(10., std::floor(level));
+    const float fineLevelWeight = static_cast<float>(1. - (level - std::floor(level)));
+
+    // For an orthographic camera, the point of the plane under a pixel and its depth are affine in the pixel position,
+    // so computing them at the corners of the screen is exact. Coordinates are relative to a multiple of the coarse
+    // spacing near the screen center to keep float precision in the shader.
+    QVector3D corners[4];
+    float depths[4];
+    const float cornerPositions[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+    for (int i = 0; i < 4; i++) {
+        const QVector3D nearPoint = inverseViewProjection * QVector3D(cornerPositions[i][0], cornerPositions[i][1], -1);
+        const QVector3D farPoint = inverseViewProjection * QVector3D(cornerPositions[i][0], cornerPositions[i][1], 1);
+        // the view is parallel to the plane
+        if (std::abs(farPoint.z() - nearPoint.z()) < 1e-6f) return;
+        const float t = -nearPoint.z() / (farPoint.z() - nearPoint.z());
+        corners[i] = nearPoint + t * (farPoint - nearPoint);
+        depths[i] = -1.f + 2.f * t;
     }
 
-    for (double i = -lineCount*lineGap/2; i < lineCount*lineGap/2; i+=lineGap){
-        glVertex3f(length / 2,i, 0);
-        glVertex3f(-length / 2,i, 0);
+    const QVector3D center = (corners[0] + corners[2]) / 2;
+    const double coarseSpacing = spacing * 10;
+    const double originX = std::floor(center.x() / coarseSpacing) * coarseSpacing;
+    const double originY = std::floor(center.y() / coarseSpacing) * coarseSpacing;
+
+    GLfloat positions[4 * 3];
+    GLfloat planePositions[4 * 2];
+    for (int i = 0; i < 4; i++) {
+        positions[3 * i] = cornerPositions[i][0];
+        positions[3 * i + 1] = cornerPositions[i][1];
+        positions[3 * i + 2] = depths[i];
+        planePositions[2 * i] = static_cast<GLfloat>(corners[i].x() - originX);
+        planePositions[2 * i + 1] = static_cast<GLfloat>(corners[i].y() - originY);
     }
 
-    glEnd();
+    display->getDisplayManager()->saveState();
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+
+    program->bind();
+    program->setUniformValue("lineColor", QVector3D(.3f, .3f, .3f));
+    program->setUniformValue("alpha", alpha);
+    program->setUniformValue("spacing", static_cast<GLfloat>(spacing));
+    program->setUniformValue("fineLevelWeight", fineLevelWeight);
+    program->enableAttributeArray("position");
+    program->enableAttributeArray("planePosition");
+    program->setAttributeArray("position", positions, 3);
+    program->setAttributeArray("planePosition", planePositions, 2);
+
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+
+    program->disableAttributeArray("position");
+    program->disableAttributeArray("planePosition");
+    program->release();
 
     display->getDisplayManager()->restoreState();
 }
-
-GridRenderer::GridRenderer(Display *display) : display(display) {}
@@ -0,0 +1,394 @@
+/*              I N S T A N C E D G E O M E T R Y . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file InstancedGeometry.cpp */
+
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include "InstancedGeometry.h"
+#include "DisplayManager.h"
+
+namespace {
+    void drawIndexRange(GLenum mode, int firstIndex, int indexCount, int instanceCount = 0)
+    {
+        const GLvoid* offset = reinterpret_cast<const GLvoid*>(static_cast<quintptr>(firstIndex) * sizeof(GLuint));
+        if (instanceCount == 0) {
+            glDrawElements(mode, indexCount, GL_UNSIGNED_INT, offset);
+        }
+        else {
+            QOpenGLExtraFunctions* functions = QOpenGLContext::currentContext()->extraFunctions();
+            functions->glDrawElementsInstanced(mode, indexCount, GL_UNSIGNED_INT, offset, instanceCount);
+        }
+    }
+
+    void setRangeSize(const PlotGeometry::DrawRange& range, GLfloat originalPointSize, GLfloat originalLineWidth)
+    {
+        if (range.mode == GL_POINTS) glPointSize(range.size > 0 ? range.size : originalPointSize);
+        else glLineWidth(range.size > 0 ? range.size : originalLineWidth);
+    }
+}
+
+
+InstancedGeometry::InstancedGeometry() : vertexBuffer(QOpenGLBuffer::VertexBuffer),
+                                         indexBuffer(QOpenGLBuffer::IndexBuffer),
+                                         surfaceVertexBuffer(QOpenGLBuffer::VertexBuffer),
+                                         surfaceIndexBuffer(QOpenGLBuffer::IndexBuffer),
+                                         instanceBuffer(QOpenGLBuffer::VertexBuffer)
+{
+    vertexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    indexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    surfaceVertexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    surfaceIndexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    // rewritten every frame with the instances in view
+    instanceBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+}
+
+bool InstancedGeometry::hasGeometry() const
+{
+    return geometrySet;
+}
+
+const PlotGeometry& InstancedGeometry::getGeometry() const
+{
+    return geometry;
+}
+
+void InstancedGeometry::setGeometry(const PlotGeometry& geometry)
+{
+    this->geometry = geometry;
+    geometrySet = true;
+    dirty = true;
+}
+
+void InstancedGeometry::addInstance(int objectId, const QMatrix4x4& transform, const float color[3])
+{
+    Instance& instance = instances[objectId];
+    instance.transform = transform;
+    instance.color[0] = color[0];
+    instance.color[1] = color[1];
+    instance.color[2] = color[2];
+}
+
+void InstancedGeometry::removeInstance(int objectId)
+{
+    instances.remove(objectId);
+}
+
+const QMatrix4x4& InstancedGeometry::getTransform(int objectId) const
+{
+    return instances.find(objectId).value().transform;
+}
+
+QList<int> InstancedGeometry::getInstanceIds() const
+{
+    return instances.keys();
+}
+
+void InstancedGeometry::destroyBuffers()
+{
+    // QOpenGLBuffer::destroy() needs the context the buffer was created in
+    for (QOpenGLBuffer* buffer : {&vertexBuffer, &indexBuffer, &surfaceVertexBuffer, &surfaceIndexBuffer, &instanceBuffer}) {
+        if (buffer->isCreated()) buffer->destroy();
+    }
+    dirty = true;
+}
+
+void InstancedGeometry::upload()
+{
+    if (!dirty || !geometrySet) return;
+    dirty = false;
+
+    auto uploadBuffer = [](QOpenGLBuffer& buffer, const void* data, int size) {
+        if (size == 0) {
+            if (buffer.isCreated()) buffer.destroy();
+            return;
+        }
+        if (!buffer.isCreated()) buffer.create();
+        buffer.bind();
+        buffer.allocate(data, size);
+        buffer.release();
+    };
+
+    // the indices of coarser levels follow the ones of level 0, so the arrays are uploaded as they are
+    uploadBuffer(vertexBuffer, geometry.vertices.constData(), geometry.vertices.size() * static_cast<int>(sizeof(GLfloat)));
+    uploadBuffer(indexBuffer, geometry.indices.constData(), geometry.indices.size() * static_cast<int>(sizeof(GLuint)));
+    uploadBuffer(surfaceVertexBuffer, geometry.surfaceVertices.constData(),
+                 geometry.surfaceVertices.size() * static_cast<int>(sizeof(GLfloat)));
+    uploadBuffer(surfaceIndexBuffer, geometry.surfaceIndices.constData(),
+                 geometry.surfaceIndices.size() * static_cast<int>(sizeof(GLuint)));
+}
+
+bool InstancedGeometry::instancingSupported()
+{
+    const QOpenGLContext* context = QOpenGLContext::currentContext();
+    const QPair<int, int> version = context->format().version();
+    return context->isOpenGLES() ? version >= qMakePair(3, 0) : version >= qMakePair(3, 3);
+}
+
+void InstancedGeometry::draw(DisplayManager* displayManager, const Programs& programs, const QBitArray& drawnObjects,
+                             const QVector<quint8>& objectLevels, const bool shaded, int& drawCalls, int& indicesDrawn)
+{
+    if (!geometrySet || instances.isEmpty()) return;
+
+    // drawn instances, the ones drawn as wireframe grouped by level of detail
+    const bool drawSurface = shaded && geometry.hasSurface() && surfaceVertexBuffer.isCreated() &&
+                             surfaceIndexBuffer.isCreated();
+    const bool drawWire = vertexBuffer.isCreated() && indexBuffer.isCreated();
+    QVector<int> surfaceInstances;
+    QVector<QVector<int>> levelInstances(geometry.levelCount());
+    for (QMap<int, Instance>::const_iterator it = instances.constBegin(); it != instances.constEnd(); ++it) {
+        const int objectId = it.key();
+        if (objectId >= drawnObjects.size() || !drawnObjects.testBit(objectId)) continue;
+        if (drawSurface) {
+            surfaceInstances.append(objectId);
+            continue;
+        }
+        if (!drawWire) continue;
+        const int level = objectId < objectLevels.size() ? objectLevels[objectId] : 0;
+        levelInstances[qMin(level, geometry.levelCount() - 1)].append(objectId);
+    }
+
+    if (programs.instancedWire != nullptr && programs.instancedSurface != nullptr && instancingSupported()) {
+        drawInstanced(programs, surfaceInstances, levelInstances, drawCalls, indicesDrawn);
+    }
+    else {
+        drawEach(displayManager, programs, surfaceInstances, levelInstances, drawCalls, indicesDrawn);
+    }
+}
+
+void InstancedGeometry::drawInstanced(const Programs& programs, const QVector<int>& surfaceInstances,
+                                      const QVector<QVector<int>>& levelInstances, int& drawCalls, int& indicesDrawn)
+{
+    // all drawn instances go to instanceBuffer in one upload: the surface instances, then the ones of each level
+    QVector<GLfloat> instanceData;
+    auto appendInstances = [this, &instanceData](const QVector<int>& objectIds) {
+        for (int objectId : objectIds) {
+            const Instance& instance = instances.find(objectId).value();
+            const float* matrix = instance.transform.constData();
+            for (int i = 0; i < 16; i++) instanceData.append(matrix[i]);
+            for (int i = 0; i < 3; i++) instanceData.append(instance.color[i]);
+        }
+    };
+    appendInstances(surfaceInstances);
+    for (const QVector<int>& objectIds : levelInstances) appendInstances(objectIds);
+    if (instanceData.isEmpty()) return;
+
+    if (!instanceBuffer.isCreated()) instanceBuffer.create();
+    instanceBuffer.bind();
+    instanceBuffer.allocate(instanceData.constData(), instanceData.size() * static_cast<int>(sizeof(GLfloat)));
+    instanceBuffer.release();
+
+    int firstInstance = 0;
+    if (!surfaceInstances.isEmpty()) {
+        programs.instancedSurface->bind();
+        bindSurface(true);
+        setInstanceAttributes(programs.instancedSurface, firstInstance, true);
+        drawIndexRange(GL_TRIANGLES, 0, geometry.surfaceIndices.size(), surfaceInstances.size());
+        drawCalls++;
+        indicesDrawn += geometry.surfaceIndices.size() * surfaceInstances.size();
+        setInstanceAttributes(programs.instancedSurface, firstInstance, false);
+        releaseSurface(true);
+        programs.instancedSurface->release();
+        firstInstance += surfaceInstances.size();
+    }
+
+    GLfloat originalPointSize, originalLineWidth;
+    glGetFloatv(GL_POINT_SIZE, &originalPointSize);
+    glGetFloatv(GL_LINE_WIDTH, &originalLineWidth);
+
+    programs.instancedWire->bind();
+    bindWire();
+    for (int level = 0; level < levelInstances.size(); level++) {
+        const int instanceCount = levelInstances[level].size();
+        if (instanceCount == 0) continue;
+        setInstanceAttributes(programs.instancedWire, firstInstance, true);
+        for (const PlotGeometry::DrawRange& range : geometry.levelRanges(level)) {
+            setRangeSize(range, originalPointSize, originalLineWidth);
+            drawIndexRange(range.mode, range.firstIndex, range.indexCount, instanceCount);
+            drawCalls++;
+            indicesDrawn += range.indexCount * instanceCount;
+        }
+        setInstanceAttributes(programs.instancedWire, firstInstance, false);
+        firstInstance += instanceCount;
+    }
+    releaseWire();
+    programs.instancedWire->release();
+
+    glPointSize(originalPointSize);
+    glLineWidth(originalLineWidth);
+}
+
+void InstancedGeometry::drawEach(DisplayManager* displayManager, const Programs& programs,
+                                 const QVector<int>& surfaceInstances, const QVector<QVector<int>>& levelInstances,
+                                 int& drawCalls, int& indicesDrawn)
+{
+    glMatrixMode(GL_MODELVIEW);
+
+    if (!surfaceInstances.isEmpty() && programs.surface != nullptr) {
+        programs.surface->bind();
+        bindSurface(true);
+        for (int objectId : surfaceInstances) {
+            const Instance& instance = instances.find(objectId).value();
+            programs.surface->setUniformValue("color", instance.color[0], instance.color[1], instance.color[2]);
+            glPushMatrix();
+            glMultMatrixf(instance.transform.constData());
+            drawIndexRange(GL_TRIANGLES, 0, geometry.surfaceIndices.size());
+            glPopMatrix();
+            drawCalls++;
+            indicesDrawn += geometry.surfaceIndices.size();
+        }
+        releaseSurface(true);
+        programs.surface->release();
+    }
+
+    GLfloat originalPointSize, originalLineWidth;
+    glGetFloatv(GL_POINT_SIZE, &originalPointSize);
+    glGetFloatv(GL_LINE_WIDTH, &originalLineWidth);
+
+    bindWire();
+    for (int level = 0; level < levelInstances.size(); level++) {
+        for (int objectId : levelInstances[level]) {
+            const Instance& instance = instances.find(objectId).value();
+            displayManager->setFGColor(instance.color[0], instance.color[1], instance.color[2], 1);
+            displayManager->applyWireMaterial();
+            glPushMatrix();
+            glMultMatrixf(instance.transform.constData());
+            for (const PlotGeometry::DrawRange& range : geometry.levelRanges(level)) {
+                setRangeSize(range, originalPointSize, originalLineWidth);
+                drawIndexRange(range.mode, range.firstIndex, range.indexCount);
+                drawCalls++;
+                indicesDrawn += range.indexCount;
+            }
+            glPopMatrix();
+        }
+    }
+    releaseWire();
+
+    glPointSize(originalPointSize);
+    glLineWidth(originalLineWidth);
+}
+
+void InstancedGeometry::drawObjectIds(const QBitArray& drawnObjects, const float lineWidth, const bool shaded)
+{
+    if (!geometrySet || instances.isEmpty()) return;
+
+    const bool drawSurface = shaded && geometry.hasSurface() && surfaceVertexBuffer.isCreated() &&
+                             surfaceIndexBuffer.isCreated();
+    if (drawSurface) bindSurface(false);
+    else if (vertexBuffer.isCreated() && indexBuffer.isCreated()) bindWire();
+    else return;
+
+    glMatrixMode(GL_MODELVIEW);
+    for (QMap<int, Instance>::const_iterator it = instances.constBegin(); it != instances.constEnd(); ++it) {
+        if (it.key() >= drawnObjects.size() || !drawnObjects.testBit(it.key())) continue;
+
+        const quint32 colorId = static_cast<quint32>(it.key()) + 1;
+        glColor3ub((colorId >> 16) & 0xff, (colorId >> 8) & 0xff, colorId & 0xff);
+        glPushMatrix();
+        glMultMatrixf(it.value().transform.constData());
+        if (drawSurface) {
+            drawIndexRange(GL_TRIANGLES, 0, geometry.surfaceIndices.size());
+        }
+        else {
+            for (const PlotGeometry::DrawRange& range : geometry.ranges) {
+                if (range.mode == GL_POINTS) glPointSize(qMax(range.size, lineWidth));
+                else glLineWidth(qMax(range.size, lineWidth));
+                drawIndexRange(range.mode, range.firstIndex, range.indexCount);
+            }
+        }
+        glPopMatrix();
+    }
+
+    if (drawSurface) releaseSurface(false);
+    else releaseWire();
+}
+
+void InstancedGeometry::bindSurface(const bool withNormals)
+{
+    surfaceVertexBuffer.bind();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 6 * sizeof(GLfloat), nullptr);
+    if (withNormals) {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, 6 * sizeof(GLfloat), reinterpret_cast<const GLvoid*>(3 * sizeof(GLfloat)));
+    }
+    surfaceIndexBuffer.bind();
+}
+
+void InstancedGeometry::releaseSurface(const bool withNormals)
+{
+    surfaceIndexBuffer.release();
+    if (withNormals) glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    surfaceVertexBuffer.release();
+}
+
+void InstancedGeometry::bindWire()
+{
+    vertexBuffer.bind();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, nullptr);
+    indexBuffer.bind();
+}
+
+void InstancedGeometry::releaseWire()
+{
+    indexBuffer.release();
+    glDisableClientState(GL_VERTEX_ARRAY);
+    vertexBuffer.release();
+}
+
+/*
+ * Points the per instance attributes of program at instanceBuffer, starting at firstInstance, and makes them advance
+ * once per instance. The divisors are reset when disabling, as they would affect every later draw otherwise.
+ */
+void InstancedGeometry::setInstanceAttributes(QOpenGLShaderProgram* program, const int firstInstance, const bool enable)
+{
+    QOpenGLExtraFunctions* functions = QOpenGLContext::currentContext()->extraFunctions();
+    const int stride = instanceFloatCount * static_cast<int>(sizeof(GLfloat));
+    const int offset = firstInstance * stride;
+    const int matrixLocation = program->attributeLocation("instanceMatrix");
+    const int colorLocation = program->attributeLocation("instanceColor");
+
+    if (enable) instanceBuffer.bind();
+    // a mat4 attribute takes one location per column
+    for (int column = 0; column < 4 && matrixLocation >= 0; column++) {
+        if (enable) {
+            program->enableAttributeArray(matrixLocation + column);
+            const int columnOffset = offset + column * 4 * static_cast<int>(sizeof(GLfloat));
+            program->setAttributeBuffer(matrixLocation + column, GL_FLOAT, columnOffset, 4, stride);
+        }
+        else {
+            program->disableAttributeArray(matrixLocation + column);
+        }
+        functions->glVertexAttribDivisor(matrixLocation + column, enable ? 1 : 0);
+    }
+    if (colorLocation >= 0) {
+        if (enable) {
+            program->enableAttributeArray(colorLocation);
+            const int colorOffset = offset + 16 * static_cast<int>(sizeof(GLfloat));
+            program->setAttributeBuffer(colorLocation, GL_FLOAT, colorOffset, 3, stride);
+        }
+        else {
+            program->disableAttributeArray(colorLocation);
+        }
+        functions->glVertexAttribDivisor(colorLocation, enable ? 1 : 0);
+    }
+    if (enable) instanceBuffer.release();
+}
@@ -21,6 +21,7 @@
 
 #include "DisplayGrid.h"
 #include "MoveCameraMouseAction.h"
+#include "ObjectTreeWidget.h"
 
 
 MoveCameraMouseAction::MoveCameraMouseAction(DisplayGrid* parent, Display* watched)
@@ -48,6 +49,9 @@ bool MoveCameraMouseAction::eventFilter(QObject* watched, QEvent* event) {
                 if (skipNextMouseMoveEvent) {
                     skipNextMouseMoveEvent = false;
                 }
+                if ((moveCameraEvent->pos() - pressPosition).manhattanLength() >= QApplication::startDragDistance()) {
+                    dragged = true;
+                }
                 if (moveCameraEvent->buttons() & (rotateCameraMouseButton)) {
                     const bool rotateThirdAxis = QApplication::keyboardModifiers().testFlag(rotateAroundThirdAxisModifier);
                     m_watched->getCamera()->processRotateRequest(x - prevMouseX, y - prevMouseY, rotateThirdAxis);
@@ -102,10 +106,17 @@ bool MoveCameraMouseAction::eventFilter(QObject* watched, QEvent* event) {
             QMouseEvent* mouseButtonPressEvent = static_cast<QMouseEvent*>(event);
             prevMouseX = mouseButtonPressEvent->x();
             prevMouseY = mouseButtonPressEvent->y();
+            pressPosition = mouseButtonPressEvent->pos();
+            dragged = false;
 
             ret        = true;
         }
         else if (event->type() == QEvent::MouseButtonRelease) {
+            QMouseEvent* mouseButtonReleaseEvent = static_cast<QMouseEvent*>(event);
+            if (mouseButtonReleaseEvent->button() == selectObjectMouseButton && !dragged) {
+                selectObjectAt(mouseButtonReleaseEvent->pos());
+            }
+
             prevMouseX = -1;
             prevMouseY = -1;
             ret        = true;
@@ -128,3 +139,9 @@ bool MoveCameraMouseAction::eventFilter(QObject* watched, QEvent* event) {
 
     return ret;
 }
+
+void MoveCameraMouseAction::selectObjectAt(const QPoint& position) {
+    const int objectId = m_watched->getObjectPicker()->pick(position.x(), position.y());
+    if (objectId < 0) return;
+    m_watched->getDocument()->getObjectTreeWidget()->selectObject(objectId);
+}
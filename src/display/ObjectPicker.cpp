@@ -0,0 +1,106 @@
+/*                   O B J E C T P I C K E R . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file ObjectPicker.cpp */
+
+#include <QOpenGLFramebufferObject>
+#include "ObjectPicker.h"
+#include "Display.h"
+#include "GeometryRenderer.h"
+
+
+ObjectPicker::ObjectPicker(Display* display) : display(display) {}
+
+ObjectPicker::~ObjectPicker()
+{
+    delete framebuffer;
+}
+
+int ObjectPicker::pick(const int x, const int y)
+{
+    if (x < 0 || y < 0 || x >= display->getW() || y >= display->getH()) return -1;
+
+    display->makeCurrent();
+    if (!isUpToDate()) render();
+
+    GLubyte pixel[4] = {0, 0, 0, 0};
+    framebuffer->bind();
+    glReadPixels(x, display->getH() - 1 - y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+    framebuffer->release();
+    display->doneCurrent();
+
+    const int colorId = (pixel[0] << 16) | (pixel[1] << 8) | pixel[2];
+    return colorId - 1;
+}
+
+bool ObjectPicker::isUpToDate() const
+{
+    if (framebuffer == nullptr) return false;
+    if (framebuffer->width() != display->getW() || framebuffer->height() != display->getH()) return false;
+    if (geometryRevision != display->getDocument()->getGeometryRenderer()->getRevision()) return false;
+    if (shaded != display->shadedModeEnabled) return false;
+
+    const OrthographicCamera* camera = display->getCamera();
+    return modelViewMatrix == camera->modelViewMatrix() && projectionMatrix == camera->projectionMatrix();
+}
+
+/*
+ * Draws the objects in view without lighting, blending or smoothing, so every pixel holds exactly the color of one
+ * object. Depth testing makes the nearest object win where objects overlap.
+ */
+void ObjectPicker::render()
+{
+    if (framebuffer == nullptr || framebuffer->width() != display->getW() || framebuffer->height() != display->getH()) {
+        delete framebuffer;
+        framebuffer = new QOpenGLFramebufferObject(display->getW(), display->getH(),
+                                                   QOpenGLFramebufferObject::Depth);
+    }
+
+    GeometryRenderer* geometryRenderer = display->getDocument()->getGeometryRenderer();
+    OrthographicCamera* camera = display->getCamera();
+    DisplayManager* displayManager = display->getDisplayManager();
+    modelViewMatrix = camera->modelViewMatrix();
+    projectionMatrix = camera->projectionMatrix();
+    geometryRevision = geometryRenderer->getRevision();
+    shaded = display->shadedModeEnabled;
+
+    framebuffer->bind();
+    displayManager->saveState();
+
+    glViewport(0, 0, display->getW(), display->getH());
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_BLEND);
+    glDisable(GL_DITHER);
+    glDisable(GL_LINE_SMOOTH);
+    glDisable(GL_POINT_SMOOTH);
+    glDisable(GL_LINE_STIPPLE);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_FOG);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LEQUAL);
+
+    displayManager->loadMatrix(modelViewMatrix.constData());
+    displayManager->loadPMatrix(projectionMatrix.constData());
+    geometryRenderer->renderObjectIds(display, pickLineWidth);
+
+    displayManager->restoreState();
+    framebuffer->release();
+}
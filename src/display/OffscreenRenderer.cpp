@@ -0,0 +1,148 @@
+/*              O F F S C R E E N R E N D E R E R . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file OffscreenRenderer.cpp */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QThread>
+#include "OffscreenRenderer.h"
+#include "Display.h"
+#include "GeometryRenderer.h"
+
+
+OffscreenRenderer::OffscreenRenderer(Document* document, const int w, const int h) : document(document)
+{
+    view = new Display(document);
+    view->setSize(w, h);
+
+    context = new QOpenGLContext();
+    context->setFormat(QSurfaceFormat::defaultFormat());
+    context->setShareContext(QOpenGLContext::globalShareContext());
+    if (!context->create()) qWarning("OffscreenRenderer: failed to create an OpenGL context");
+
+    surface = new QOffscreenSurface();
+    surface->setFormat(context->format());
+    surface->create();
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+    if (makeCurrent()) {
+        delete framebuffer;
+        context->doneCurrent();
+    }
+    delete view;
+    delete context;
+    delete surface;
+}
+
+bool OffscreenRenderer::isValid() const
+{
+    return context->isValid() && surface->isValid();
+}
+
+Display* OffscreenRenderer::getView() const
+{
+    return view;
+}
+
+int OffscreenRenderer::getW() const
+{
+    return view->getW();
+}
+
+int OffscreenRenderer::getH() const
+{
+    return view->getH();
+}
+
+void OffscreenRenderer::resize(const int w, const int h)
+{
+    view->setSize(w, h);
+}
+
+bool OffscreenRenderer::makeCurrent()
+{
+    return isValid() && context->makeCurrent(surface);
+}
+
+// multisampled if the framebuffer can be resolved by blitting, which grabImage relies on
+void OffscreenRenderer::createFramebuffer()
+{
+    delete framebuffer;
+    QOpenGLFramebufferObjectFormat format;
+    format.setAttachment(QOpenGLFramebufferObject::Depth);
+    if (QOpenGLFramebufferObject::hasOpenGLFramebufferBlit()) format.setSamples(samples);
+    framebuffer = new QOpenGLFramebufferObject(getW(), getH(), format);
+}
+
+void OffscreenRenderer::renderFrame()
+{
+    if (!makeCurrent()) return;
+    if (framebuffer == nullptr || framebuffer->width() != getW() || framebuffer->height() != getH()) {
+        createFramebuffer();
+    }
+
+    framebuffer->bind();
+    view->drawScene();
+    framebuffer->release();
+}
+
+/*
+ * The first frame requests the plots of the visible objects. Then frames are rendered while the plotter works, and
+ * each one adds what finished in the mean time (within GeometryRenderer's upload time budget).
+ */
+bool OffscreenRenderer::renderUntilComplete(const int timeoutMs)
+{
+    const GeometryRenderer* geometryRenderer = document->getGeometryRenderer();
+    QElapsedTimer timer;
+    timer.start();
+
+    renderFrame();
+    while (!geometryRenderer->isComplete()) {
+        if (timer.elapsed() > timeoutMs) return false;
+        QCoreApplication::processEvents();
+        if (!geometryRenderer->getPlotter()->hasFinished()) QThread::msleep(5);
+        renderFrame();
+    }
+    return true;
+}
+
+void OffscreenRenderer::finish()
+{
+    if (!makeCurrent()) return;
+    context->functions()->glFinish();
+}
+
+QImage OffscreenRenderer::grabImage()
+{
+    if (framebuffer == nullptr || !makeCurrent()) return QImage();
+    return framebuffer->toImage().convertToFormat(QImage::Format_RGB32);
+}
+
+QString OffscreenRenderer::getRendererName()
+{
+    if (!makeCurrent()) return QString();
+    return QString::fromLatin1(reinterpret_cast<const char*>(context->functions()->glGetString(GL_RENDERER)));
+}
@@ -138,8 +138,9 @@ double OrthographicCamera::getVerticalSpan()
 }
 
 void OrthographicCamera::centerToCurrentSelection() {
-    BRLCAD::Vector3D a = document->getDatabase()->BoundingBoxMinima();
-    BRLCAD::Vector3D b = document->getDatabase()->BoundingBoxMaxima();
+    BRLCAD::Vector3D a;
+    BRLCAD::Vector3D b;
+    document->getSelectionBoundingBox(a, b);
     BRLCAD::Vector3D midPoint = (a+b) / 2;
     setEyePosition(midPoint.coordinates[0], midPoint.coordinates[1], midPoint.coordinates[2]);
 
@@ -150,30 +151,12 @@ void OrthographicCamera::centerToCurrentSelection() {
 }
 
 void OrthographicCamera::autoview() {
-    document->getDatabase()->UnSelectAll();
-    document->getObjectTree()->traverseSubTree(0, false, [this]
-    (int objectId){
-        switch(document->getObjectTree()->getObjectVisibility()[objectId]){
-            case ObjectTree::Invisible:
-                return false;
-            case ObjectTree::SomeChildrenVisible:
-                return true;
-            case ObjectTree::FullyVisible:
-                QString fullPath = document->getObjectTree()->getFullPathMap()[objectId];
-                document->getDatabase()->Select(fullPath.toUtf8());
-                return false;
-        }
-        return true;
-    }
-    );
-
+    document->selectObjects(document->getVisibleObjectPaths());
     centerToCurrentSelection();
 }
 
 void OrthographicCamera::centerView(int objectId) {
-    document->getDatabase()->UnSelectAll();
-    QString fullPath = document->getObjectTree()->getFullPathMap()[objectId];
-    document->getDatabase()->Select(fullPath.toUtf8());
+    document->selectObjects({document->getObjectTree()->getFullPathMap()[objectId]});
     centerToCurrentSelection();
 }
 
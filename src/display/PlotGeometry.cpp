@@ -0,0 +1,372 @@
+/*                   P L O T G E O M E T R Y . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file PlotGeometry.cpp */
+
+#include <QHash>
+#include <QMap>
+#include <QVector3D>
+#include <QPair>
+#include "PlotGeometry.h"
+
+namespace {
+    struct SurfaceVertex {
+        QVector3D point;
+        QVector3D normal;
+
+        bool operator==(const SurfaceVertex& other) const
+        {
+            return point == other.point && normal == other.normal;
+        }
+    };
+
+    uint qHash(const SurfaceVertex& vertex, uint seed = 0)
+    {
+        const float components[6] = {vertex.point.x(), vertex.point.y(), vertex.point.z(),
+                                     vertex.normal.x(), vertex.normal.y(), vertex.normal.z()};
+        return qHashBits(components, sizeof(components), seed);
+    }
+
+    class PlotGeometryElementCallback : public BRLCAD::VectorList::ElementCallback {
+    public:
+        typedef QPair<GLenum, float> RangeKey;
+
+        PlotGeometry& geometry;
+        QMap<RangeKey, QVector<GLuint>> indices;   // indices for each primitive and size, merged at the end
+        float lineWidth = 0;
+        float pointSize = 0;
+        int previousVertex = -1;
+        int polygonFirstVertex = -1;
+
+        // the polygon or triangle being read, and the normals that apply to its next vertex
+        QVector<SurfaceVertex> polygon;
+        QVector3D faceNormal;
+        QVector3D vertexNormal;
+        bool hasVertexNormal = false;
+        // identical vertices of the surface are shared
+        QHash<SurfaceVertex, GLuint> surfaceVertexIndices;
+
+        explicit PlotGeometryElementCallback(PlotGeometry& geometry) : geometry(geometry) {}
+
+        static QVector3D toVector(const BRLCAD::Vector3D& vector)
+        {
+            return QVector3D(static_cast<float>(vector.coordinates[0]), static_cast<float>(vector.coordinates[1]),
+                             static_cast<float>(vector.coordinates[2]));
+        }
+
+        void addPolygonVertex(const BRLCAD::Vector3D& point)
+        {
+            polygon.append({toVector(point), hasVertexNormal ? vertexNormal : faceNormal});
+            hasVertexNormal = false;
+        }
+
+        GLuint surfaceVertexIndex(const SurfaceVertex& vertex)
+        {
+            QHash<SurfaceVertex, GLuint>::const_iterator it = surfaceVertexIndices.constFind(vertex);
+            if (it != surfaceVertexIndices.constEnd()) return it.value();
+
+            const GLuint index = static_cast<GLuint>(geometry.surfaceVertexCount());
+            const float components[6] = {vertex.point.x(), vertex.point.y(), vertex.point.z(),
+                                         vertex.normal.x(), vertex.normal.y(), vertex.normal.z()};
+            for (float component : components) geometry.surfaceVertices.append(component);
+            surfaceVertexIndices.insert(vertex, index);
+            return index;
+        }
+
+        // polygons of a plot are convex, so a fan triangulates them
+        void endPolygon()
+        {
+            if (polygon.size() > 3 && polygon.first().point == polygon.last().point) polygon.removeLast();
+            if (polygon.size() >= 3) {
+                const GLuint first = surfaceVertexIndex(polygon[0]);
+                GLuint previous = surfaceVertexIndex(polygon[1]);
+                for (int i = 2; i < polygon.size(); i++) {
+                    const GLuint current = surfaceVertexIndex(polygon[i]);
+                    if (first != previous && previous != current && current != first) {
+                        geometry.surfaceIndices.append(first);
+                        geometry.surfaceIndices.append(previous);
+                        geometry.surfaceIndices.append(current);
+                    }
+                    previous = current;
+                }
+            }
+            polygon.clear();
+            hasVertexNormal = false;
+        }
+
+        int addVertex(const BRLCAD::Vector3D& point)
+        {
+            geometry.vertices.append(static_cast<GLfloat>(point.coordinates[0]));
+            geometry.vertices.append(static_cast<GLfloat>(point.coordinates[1]));
+            geometry.vertices.append(static_cast<GLfloat>(point.coordinates[2]));
+            return geometry.vertexCount() - 1;
+        }
+
+        void addLine(int from, int to)
+        {
+            if (from < 0) return;
+            QVector<GLuint>& lines = indices[RangeKey(GL_LINES, lineWidth)];
+            lines.append(from);
+            lines.append(to);
+        }
+
+        // The element type tells the exact class, so static_cast is enough
+        bool operator()(BRLCAD::VectorList::Element* element) override
+        {
+            if (!element) return true;
+
+            switch (element->Type()) {
+                case BRLCAD::VectorList::Element::LineMove:
+                    previousVertex = addVertex(static_cast<BRLCAD::VectorList::LineMove*>(element)->Point());
+                    break;
+                case BRLCAD::VectorList::Element::LineDraw: {
+                    const int vertex = addVertex(static_cast<BRLCAD::VectorList::LineDraw*>(element)->Point());
+                    addLine(previousVertex, vertex);
+                    previousVertex = vertex;
+                    break;
+                }
+                case BRLCAD::VectorList::Element::PointDraw: {
+                    const int vertex = addVertex(static_cast<BRLCAD::VectorList::PointDraw*>(element)->Point());
+                    indices[RangeKey(GL_POINTS, pointSize)].append(vertex);
+                    break;
+                }
+                case BRLCAD::VectorList::Element::PolygonStart:
+                    previousVertex = -1;
+                    polygonFirstVertex = -1;
+                    polygon.clear();
+                    faceNormal = toVector(static_cast<BRLCAD::VectorList::PolygonStart*>(element)->Normal());
+                    break;
+                case BRLCAD::VectorList::Element::TriangleStart:
+                    previousVertex = -1;
+                    polygonFirstVertex = -1;
+                    polygon.clear();
+                    faceNormal = toVector(static_cast<BRLCAD::VectorList::TriangleStart*>(element)->Normal());
+                    break;
+                case BRLCAD::VectorList::Element::PolygonVertexNormal:
+                    vertexNormal = toVector(static_cast<BRLCAD::VectorList::PolygonVertexNormal*>(element)->Normal());
+                    hasVertexNormal = true;
+                    break;
+                case BRLCAD::VectorList::Element::TriangleVertexNormal:
+                    vertexNormal = toVector(static_cast<BRLCAD::VectorList::TriangleVertexNormal*>(element)->Normal());
+                    hasVertexNormal = true;
+                    break;
+                case BRLCAD::VectorList::Element::PolygonMove:
+                case BRLCAD::VectorList::Element::PolygonDraw:
+                case BRLCAD::VectorList::Element::TriangleMove:
+                case BRLCAD::VectorList::Element::TriangleDraw: {
+                    BRLCAD::Vector3D point;
+                    switch (element->Type()) {
+                        case BRLCAD::VectorList::Element::PolygonMove:
+                            point = static_cast<BRLCAD::VectorList::PolygonMove*>(element)->Point();
+                            break;
+                        case BRLCAD::VectorList::Element::PolygonDraw:
+                            point = static_cast<BRLCAD::VectorList::PolygonDraw*>(element)->Point();
+                            break;
+                        case BRLCAD::VectorList::Element::TriangleMove:
+                            point = static_cast<BRLCAD::VectorList::TriangleMove*>(element)->Point();
+                            break;
+                        default:
+                            point = static_cast<BRLCAD::VectorList::TriangleDraw*>(element)->Point();
+                            break;
+                    }
+                    const int vertex = addVertex(point);
+                    if (polygonFirstVertex < 0) polygonFirstVertex = vertex;
+                    addLine(previousVertex, vertex);
+                    previousVertex = vertex;
+                    addPolygonVertex(point);
+                    break;
+                }
+                case BRLCAD::VectorList::Element::PolygonEnd: {
+                    const BRLCAD::Vector3D point = static_cast<BRLCAD::VectorList::PolygonEnd*>(element)->Point();
+                    const int vertex = addVertex(point);
+                    addLine(previousVertex, vertex);
+                    addLine(vertex, polygonFirstVertex);
+                    previousVertex = -1;
+                    polygonFirstVertex = -1;
+                    addPolygonVertex(point);
+                    endPolygon();
+                    break;
+                }
+                case BRLCAD::VectorList::Element::TriangleEnd:
+                    addLine(previousVertex, polygonFirstVertex);
+                    previousVertex = -1;
+                    polygonFirstVertex = -1;
+                    endPolygon();
+                    break;
+                case BRLCAD::VectorList::Element::LineWidth: {
+                    const float width = static_cast<float>(static_cast<BRLCAD::VectorList::LineWidth*>(element)->Width());
+                    if (width > 0) lineWidth = width;
+                    break;
+                }
+                case BRLCAD::VectorList::Element::PointSize: {
+                    const float size = static_cast<float>(static_cast<BRLCAD::VectorList::PointSize*>(element)->Size());
+                    if (size > 0) pointSize = size;
+                    break;
+                }
+                default:
+                    break;
+            }
+            return true;
+        }
+    };
+}
+
+
+PlotGeometry PlotGeometry::fromVectorList(BRLCAD::VectorList& vectorList)
+{
+    PlotGeometry geometry;
+    PlotGeometryElementCallback callback(geometry);
+    vectorList.Iterate(callback);
+
+    for (QMap<PlotGeometryElementCallback::RangeKey, QVector<GLuint>>::const_iterator it = callback.indices.constBegin();
+         it != callback.indices.constEnd(); ++it) {
+        if (it.value().isEmpty()) continue;
+        DrawRange range;
+        range.mode = it.key().first;
+        range.size = it.key().second;
+        range.firstIndex = geometry.indices.size();
+        range.indexCount = it.value().size();
+        geometry.ranges.append(range);
+        geometry.indices.append(it.value());
+    }
+    geometry.updateBounds();
+
+    return geometry;
+}
+
+void PlotGeometry::updateBounds()
+{
+    bounds = AxisAlignedBox();
+    for (int i = 0; i + 2 < vertices.size(); i += 3) {
+        bounds.add(QVector3D(vertices[i], vertices[i + 1], vertices[i + 2]));
+    }
+}
+
+float PlotGeometry::levelTolerance(int level)
+{
+    // each level is meant for a quarter of the screen size of the previous one (see GeometryRenderer)
+    static const float tolerances[maxLevelCount] = {0.f, .0025f, .01f, .04f};
+    return tolerances[level];
+}
+
+namespace {
+    float squaredDistanceToSegment(const QVector3D& point, const QVector3D& a, const QVector3D& b)
+    {
+        const QVector3D ab = b - a;
+        const float lengthSquared = ab.lengthSquared();
+        float t = lengthSquared > 0.f ? QVector3D::dotProduct(point - a, ab) / lengthSquared : 0.f;
+        t = qBound(0.f, t, 1.f);
+        return (a + t * ab - point).lengthSquared();
+    }
+
+    // Douglas-Peucker, appends the index pairs of the simplified strip to lines
+    void simplifyStrip(const QVector<GLfloat>& vertices, const QVector<GLuint>& strip, float tolerance, QVector<GLuint>& lines)
+    {
+        auto vertex = [&vertices](GLuint index) {
+            return QVector3D(vertices[3 * index], vertices[3 * index + 1], vertices[3 * index + 2]);
+        };
+
+        QVector<bool> keep(strip.size(), false);
+        keep.first() = true;
+        keep.last() = true;
+
+        const float toleranceSquared = tolerance * tolerance;
+        QVector<QPair<int, int>> stack;
+        stack.append(QPair<int, int>(0, strip.size() - 1));
+        while (!stack.isEmpty()) {
+            const QPair<int, int> span = stack.takeLast();
+            const QVector3D a = vertex(strip[span.first]);
+            const QVector3D b = vertex(strip[span.second]);
+
+            int furthest = -1;
+            float furthestDistance = toleranceSquared;
+            for (int i = span.first + 1; i < span.second; i++) {
+                const float distance = squaredDistanceToSegment(vertex(strip[i]), a, b);
+                if (distance > furthestDistance) {
+                    furthest = i;
+                    furthestDistance = distance;
+                }
+            }
+
+            if (furthest >= 0) {
+                keep[furthest] = true;
+                stack.append(QPair<int, int>(span.first, furthest));
+                stack.append(QPair<int, int>(furthest, span.second));
+            }
+        }
+
+        int previous = 0;
+        for (int i = 1; i < strip.size(); i++) {
+            if (!keep[i]) continue;
+            lines.append(strip[previous]);
+            lines.append(strip[i]);
+            previous = i;
+        }
+    }
+}
+
+void PlotGeometry::generateLevels()
+{
+    coarseLevels.clear();
+    if (bounds.isEmpty()) return;
+    const float diagonal = bounds.size().length();
+
+    int previousIndexCount = 0;
+    for (const DrawRange& range : ranges) previousIndexCount += range.indexCount;
+
+    for (int level = 1; level < maxLevelCount; level++) {
+        const float tolerance = levelTolerance(level) * diagonal;
+        const int firstLevelIndex = indices.size();
+        QVector<DrawRange> levelRanges;
+
+        for (const DrawRange& range : ranges) {
+            QVector<GLuint> levelIndices;
+            if (range.mode != GL_LINES) {
+                levelIndices = indices.mid(range.firstIndex, range.indexCount);
+            }
+            else {
+                // consecutive line segments sharing a vertex are one strip of the vector list
+                QVector<GLuint> strip;
+                for (int i = range.firstIndex; i + 1 < range.firstIndex + range.indexCount; i += 2) {
+                    if (!strip.isEmpty() && strip.last() != indices[i]) {
+                        simplifyStrip(vertices, strip, tolerance, levelIndices);
+                        strip.clear();
+                    }
+                    if (strip.isEmpty()) strip.append(indices[i]);
+                    strip.append(indices[i + 1]);
+                }
+                if (!strip.isEmpty()) simplifyStrip(vertices, strip, tolerance, levelIndices);
+            }
+
+            DrawRange levelRange = range;
+            levelRange.firstIndex = indices.size();
+            levelRange.indexCount = levelIndices.size();
+            indices.append(levelIndices);
+            if (levelRange.indexCount > 0) levelRanges.append(levelRange);
+        }
+
+        const int levelIndexCount = indices.size() - firstLevelIndex;
+        if (levelIndexCount > previousIndexCount * 9 / 10) {
+            indices.resize(firstLevelIndex);
+            break;
+        }
+        coarseLevels.append(levelRanges);
+        previousIndexCount = levelIndexCount;
+    }
+}
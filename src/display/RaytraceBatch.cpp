@@ -0,0 +1,143 @@
+/*                  R A Y T R A C E B A T C H . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file RaytraceBatch.cpp */
+
+#include <algorithm>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include "RaytraceBatch.h"
+#include "Display.h"
+#include "DisplayGrid.h"
+#include "Document.h"
+#include "OrthographicCamera.h"
+
+
+namespace {
+    const char* standardViewNames[] = {"top", "front", "side", "iso"};
+    const int isoView = 3;
+
+    // writes a traced frame and frees its slot
+    class WriteFrameTask : public QRunnable {
+    public:
+        WriteFrameTask(const QImage& image, RaytraceBatch::Frame* frame, QSemaphore* pendingWrites) :
+            image(image), frame(frame), pendingWrites(pendingWrites) {}
+
+        void run() override
+        {
+            QDir().mkpath(QFileInfo(frame->filePath).absolutePath());
+            frame->written = image.save(frame->filePath);
+            pendingWrites->release();
+        }
+
+    private:
+        QImage image;
+        RaytraceBatch::Frame* frame;
+        QSemaphore* pendingWrites;
+    };
+}
+
+
+QVector<RaytraceBatch::View> RaytraceBatch::standardViews()
+{
+    QVector<View> views;
+    for (int i = 0; i < 4; i++) {
+        const double* angles = DisplayGrid::defaultDisplayCameraRotation[i];
+        views.append({standardViewNames[i], QVector3D(angles[0], angles[1], angles[2])});
+    }
+    return views;
+}
+
+QVector<RaytraceBatch::View> RaytraceBatch::turntableViews(const int frameCount)
+{
+    const double* angles = DisplayGrid::defaultDisplayCameraRotation[isoView];
+    const int nameWidth = QString::number(std::max(frameCount - 1, 0)).size();
+    QVector<View> views;
+    for (int i = 0; i < frameCount; i++) {
+        views.append({"turntable" + QString::number(i).rightJustified(nameWidth, '0'),
+                      QVector3D(angles[0], angles[1], angles[2] + 360. * i / frameCount)});
+    }
+    return views;
+}
+
+bool RaytraceBatch::isValidPattern(const QString& outputPattern)
+{
+    return outputPattern.contains("{view}") || outputPattern.contains("{index}");
+}
+
+RaytraceBatch::RaytraceBatch(Document* document, const int w, const int h) :
+    document(document), w(w), h(h), raytracer(document) {}
+
+void RaytraceBatch::setBackground(const QColor& background)
+{
+    this->background = background;
+}
+
+void RaytraceBatch::setAntiAliasingEnabled(const bool enabled)
+{
+    raytracer.setAntiAliasingEnabled(enabled);
+}
+
+QString RaytraceBatch::filePath(const QString& outputPattern, const View& view, const int index,
+                                const int indexWidth) const
+{
+    QString path = outputPattern;
+    const QString documentName = document->getFilePath() != nullptr ?
+                                 QFileInfo(*document->getFilePath()).completeBaseName() : QString("untitled");
+    path.replace("{file}", documentName);
+    path.replace("{view}", view.name);
+    path.replace("{index}", QString::number(index).rightJustified(indexWidth, '0'));
+    return path;
+}
+
+QVector<RaytraceBatch::Frame> RaytraceBatch::run(const QVector<View>& views, const QString& outputPattern)
+{
+    // an autoview only depends on the objects, not on the camera's angles
+    const QStringList selectedPaths = document->getVisibleObjectPaths();
+    OrthographicCamera camera(document);
+    camera.autoview();
+
+    // the write tasks point into frames, so it is not resized after this
+    QVector<Frame> frames(views.size());
+    const int indexWidth = QString::number(std::max(views.size() - 1, 0)).size();
+    QThreadPool writePool;
+    writePool.setMaxThreadCount(maxPendingWrites);
+    QSemaphore pendingWrites(maxPendingWrites);
+    QElapsedTimer timer;
+    for (int i = 0; i < views.size(); i++) {
+        frames[i].viewName = views[i].name;
+        frames[i].filePath = filePath(outputPattern, views[i], i, indexWidth);
+
+        timer.start();
+        const QMatrix4x4 transformation = Raytracer::viewTransformation(camera.getEyePosition(),
+                                                                        views[i].anglesAroundAxes,
+                                                                        camera.getVerticalSpan(), w, h);
+        const QImage image = raytracer.render(transformation, w, h, background, selectedPaths);
+        frames[i].traceMs = timer.nsecsElapsed() / 1e6;
+
+        pendingWrites.acquire();
+        writePool.start(new WriteFrameTask(image, &frames[i], &pendingWrites));
+    }
+    writePool.waitForDone();
+    return frames;
+}
@@ -0,0 +1,213 @@
+/*                R A Y T R A C E S H A D I N G . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file RaytraceShading.cpp */
+
+#include <algorithm>
+#include "RaytraceShading.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RT3_SHADE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RT3_SHADE_SSE2
+#endif
+
+
+/*
+ * The lighting is the one RaytraceView always had: a light at the eye, ambient .1, diffuse and specular weight .5 and a
+ * specular exponent of 4. With a unit normal n and dot = direction.n, the reflected direction is a unit vector and
+ * reflected.direction = 1 - 2 dot², so the kernels need neither a square root nor pow.
+ */
+namespace {
+    const float ambient = .1f;
+    const float diffuseWeight = .5f;
+    const float specularWeight = .5f;
+
+    void shadeScalar(const RayHits& hits, const int first, const int end, const QVector3D& direction,
+                     const QRgb background, QRgb* colors)
+    {
+        for (int i = first; i < end; i++) {
+            if (hits.region[i] == 0) {
+                colors[i] = background;
+                continue;
+            }
+            const float dot = direction.x() * hits.normalX[i] + direction.y() * hits.normalY[i] +
+                              direction.z() * hits.normalZ[i];
+            const float brightness = ambient - dot * diffuseWeight;
+            const float reflectedDotDirection = std::max(0.f, 1.f - 2.f * dot * dot);
+            const float reflectedSquared = reflectedDotDirection * reflectedDotDirection;
+            const float specular = reflectedSquared * reflectedSquared * specularWeight;
+
+            const auto channel = [brightness, specular](const float color) {
+                return static_cast<int>(std::min(std::max(color * brightness + specular, 0.f), 1.f) * 255.f + .5f);
+            };
+            colors[i] = qRgb(channel(hits.red[i]), channel(hits.green[i]), channel(hits.blue[i]));
+        }
+    }
+
+#if defined(RT3_SHADE_AVX2)
+    int shadeVectorized(const RayHits& hits, const int count, const QVector3D& direction, const QRgb background,
+                        QRgb* colors)
+    {
+        const __m256 directionX = _mm256_set1_ps(direction.x());
+        const __m256 directionY = _mm256_set1_ps(direction.y());
+        const __m256 directionZ = _mm256_set1_ps(direction.z());
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.f);
+        const __m256 two = _mm256_set1_ps(2.f);
+        const __m256 ambientValue = _mm256_set1_ps(ambient);
+        const __m256 diffuseWeightValue = _mm256_set1_ps(diffuseWeight);
+        const __m256 specularWeightValue = _mm256_set1_ps(specularWeight);
+        const __m256 scale = _mm256_set1_ps(255.f);
+        const __m256 half = _mm256_set1_ps(.5f);
+        const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+        const __m256i backgroundValue = _mm256_set1_epi32(static_cast<int>(background));
+
+        const auto channel = [&](const __m256 color, const __m256 brightness, const __m256 specular) {
+            const __m256 value = _mm256_add_ps(_mm256_mul_ps(color, brightness), specular);
+            const __m256 clamped = _mm256_min_ps(_mm256_max_ps(value, zero), one);
+            return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(clamped, scale), half));
+        };
+
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256 dot = _mm256_add_ps(_mm256_add_ps(
+                    _mm256_mul_ps(directionX, _mm256_loadu_ps(hits.normalX.constData() + i)),
+                    _mm256_mul_ps(directionY, _mm256_loadu_ps(hits.normalY.constData() + i))),
+                    _mm256_mul_ps(directionZ, _mm256_loadu_ps(hits.normalZ.constData() + i)));
+            const __m256 brightness = _mm256_sub_ps(ambientValue, _mm256_mul_ps(dot, diffuseWeightValue));
+            const __m256 reflected = _mm256_max_ps(zero, _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_mul_ps(dot, dot))));
+            const __m256 reflectedSquared = _mm256_mul_ps(reflected, reflected);
+            const __m256 specular = _mm256_mul_ps(_mm256_mul_ps(reflectedSquared, reflectedSquared), specularWeightValue);
+
+            const __m256i red = channel(_mm256_loadu_ps(hits.red.constData() + i), brightness, specular);
+            const __m256i green = channel(_mm256_loadu_ps(hits.green.constData() + i), brightness, specular);
+            const __m256i blue = channel(_mm256_loadu_ps(hits.blue.constData() + i), brightness, specular);
+            const __m256i shaded = _mm256_or_si256(_mm256_or_si256(alpha, _mm256_slli_epi32(red, 16)),
+                                                   _mm256_or_si256(_mm256_slli_epi32(green, 8), blue));
+
+            const __m256i region = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hits.region.constData() + i));
+            const __m256i missed = _mm256_cmpeq_epi32(region, _mm256_setzero_si256());
+            const __m256i pixels = _mm256_or_si256(_mm256_and_si256(missed, backgroundValue),
+                                                   _mm256_andnot_si256(missed, shaded));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(colors + i), pixels);
+        }
+        return i;
+    }
+#elif defined(RT3_SHADE_SSE2)
+    int shadeVectorized(const RayHits& hits, const int count, const QVector3D& direction, const QRgb background,
+                        QRgb* colors)
+    {
+        const __m128 directionX = _mm_set1_ps(direction.x());
+        const __m128 directionY = _mm_set1_ps(direction.y());
+        const __m128 directionZ = _mm_set1_ps(direction.z());
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 two = _mm_set1_ps(2.f);
+        const __m128 ambientValue = _mm_set1_ps(ambient);
+        const __m128 diffuseWeightValue = _mm_set1_ps(diffuseWeight);
+        const __m128 specularWeightValue = _mm_set1_ps(specularWeight);
+        const __m128 scale = _mm_set1_ps(255.f);
+        const __m128 half = _mm_set1_ps(.5f);
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000u));
+        const __m128i backgroundValue = _mm_set1_epi32(static_cast<int>(background));
+
+        const auto channel = [&](const __m128 color, const __m128 brightness, const __m128 specular) {
+            const __m128 value = _mm_add_ps(_mm_mul_ps(color, brightness), specular);
+            const __m128 clamped = _mm_min_ps(_mm_max_ps(value, zero), one);
+            return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, scale), half));
+        };
+
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128 dot = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(directionX, _mm_loadu_ps(hits.normalX.constData() + i)),
+                    _mm_mul_ps(directionY, _mm_loadu_ps(hits.normalY.constData() + i))),
+                    _mm_mul_ps(directionZ, _mm_loadu_ps(hits.normalZ.constData() + i)));
+            const __m128 brightness = _mm_sub_ps(ambientValue, _mm_mul_ps(dot, diffuseWeightValue));
+            const __m128 reflected = _mm_max_ps(zero, _mm_sub_ps(one, _mm_mul_ps(two, _mm_mul_ps(dot, dot))));
+            const __m128 reflectedSquared = _mm_mul_ps(reflected, reflected);
+            const __m128 specular = _mm_mul_ps(_mm_mul_ps(reflectedSquared, reflectedSquared), specularWeightValue);
+
+            const __m128i red = channel(_mm_loadu_ps(hits.red.constData() + i), brightness, specular);
+            const __m128i green = channel(_mm_loadu_ps(hits.green.constData() + i), brightness, specular);
+            const __m128i blue = channel(_mm_loadu_ps(hits.blue.constData() + i), brightness, specular);
+            const __m128i shaded = _mm_or_si128(_mm_or_si128(alpha, _mm_slli_epi32(red, 16)),
+                                                _mm_or_si128(_mm_slli_epi32(green, 8), blue));
+
+            const __m128i region = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hits.region.constData() + i));
+            const __m128i missed = _mm_cmpeq_epi32(region, _mm_setzero_si128());
+            const __m128i pixels = _mm_or_si128(_mm_and_si128(missed, backgroundValue), _mm_andnot_si128(missed, shaded));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(colors + i), pixels);
+        }
+        return i;
+    }
+#else
+    int shadeVectorized(const RayHits&, int, const QVector3D&, QRgb, QRgb*)
+    {
+        return 0;
+    }
+#endif
+}
+
+
+void RayHits::resize(const int count)
+{
+    normalX.resize(count);
+    normalY.resize(count);
+    normalZ.resize(count);
+    red.resize(count);
+    green.resize(count);
+    blue.resize(count);
+    depth.resize(count);
+    region.resize(count);
+}
+
+void RayHits::set(const int index, const QVector3D& normal, const float red, const float green, const float blue,
+                  const float depth, const quint32 region)
+{
+    normalX[index] = normal.x();
+    normalY[index] = normal.y();
+    normalZ[index] = normal.z();
+    this->red[index] = red;
+    this->green[index] = green;
+    this->blue[index] = blue;
+    this->depth[index] = depth;
+    this->region[index] = region;
+}
+
+// the other values are left as they are, shadeHits computes garbage for them and then takes the background
+void RayHits::setMissed(const int index)
+{
+    region[index] = 0;
+}
+
+void shadeHits(const RayHits& hits, const int count, const QVector3D& direction, const QRgb background, QRgb* colors)
+{
+    const int vectorizedCount = shadeVectorized(hits, count, direction, background, colors);
+    shadeScalar(hits, vectorizedCount, count, direction, background, colors);
+}
+
+void shadeHitsScalar(const RayHits& hits, const int count, const QVector3D& direction, const QRgb background,
+                     QRgb* colors)
+{
+    shadeScalar(hits, 0, count, direction, background, colors);
+}
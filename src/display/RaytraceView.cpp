@@ -28,14 +28,21 @@
  *      implementation of the graphical visualization
  */
 
+#include <algorithm>
 #include <cmath>
 
 #include <QPainter>
 
 #include "RaytraceView.h"
 #include <QBitmap>
+#include <QBoxLayout>
 #include <QtWidgets/QFileDialog>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QHeaderView>
 #include <QtOpenGL/QtOpenGL>
+#include "MainWindow.h"
 
 RaytraceView::RaytraceView
 (
@@ -47,10 +54,88 @@ RaytraceView::RaytraceView
     m_transformation(),
     m_image(),
     m_imageUpTodate(false),
-    m_updatingImage(false) {
+    m_updatingImage(false),
+    m_raytracer(new Raytracer(document)),
+    m_raytraceId(0),
+    m_progressBar(new QProgressBar()),
+    m_cancelButton(new QPushButton("Cancel")),
+    m_saveButton(new QPushButton("Save...")),
+    m_fileWriter(nullptr),
+    m_overlapMode(false),
+    m_overlapList(new QTreeWidget()) {
     setMinimumSize(100, 100);
     setWindowIcon(*new QIcon(*new QBitmap(":/icons/arbalest_icon.png")));
     setWindowFlags(Qt::Window| Qt::WindowCloseButtonHint);
+
+    // the raytrace runs in the background, the image is refined as tiles come in
+    QHBoxLayout* bottomBar = new QHBoxLayout();
+    bottomBar->addStretch();
+    bottomBar->addWidget(m_progressBar);
+    bottomBar->addWidget(m_cancelButton);
+    bottomBar->addWidget(m_saveButton);
+    // the overlapping region pairs of an overlap raytrace, to the right of the image
+    QHBoxLayout* content = new QHBoxLayout();
+    content->addStretch();
+    content->addWidget(m_overlapList);
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addLayout(content, 1);
+    layout->addLayout(bottomBar);
+    m_overlapList->setFixedWidth(overlapListWidth);
+    m_overlapList->setRootIsDecorated(false);
+    m_overlapList->setHeaderLabels({"Overlapping regions", "Volume (mm^3)", "Max depth (mm)"});
+    m_overlapList->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_overlapList->header()->setStretchLastSection(false);
+    m_overlapList->hide();
+    m_progressBar->setMaximumWidth(200);
+    m_progressBar->hide();
+    m_cancelButton->hide();
+    m_saveButton->hide();
+
+    connect(m_cancelButton, &QPushButton::clicked, this, [this]() {
+        m_raytracer->cancel();
+    });
+    connect(m_saveButton, &QPushButton::clicked, this, &RaytraceView::saveImage);
+
+    connect(m_raytracer, &Raytracer::tileFinished, this, [this](quint64 raytraceId, const QRect& rect,
+                                                                const QImage& pixels) {
+        if (raytraceId != m_raytraceId) return;
+        QPainter painter(&m_image);
+        painter.drawImage(rect.topLeft(), pixels);
+        update(rect);
+    });
+    connect(m_raytracer, &Raytracer::progressChanged, this, [this](quint64 raytraceId, int finishedTileCount,
+                                                                   int tileCount) {
+        if (raytraceId != m_raytraceId) return;
+        m_progressBar->setMaximum(tileCount);
+        m_progressBar->setValue(finishedTileCount);
+    });
+    connect(m_raytracer, &Raytracer::finished, this, [this](quint64 raytraceId, bool cancelled) {
+        if (raytraceId != m_raytraceId) return;
+        if (m_fileWriter != nullptr) {
+            fileRaytraceFinished(cancelled);
+            return;
+        }
+        m_progressBar->hide();
+        m_cancelButton->hide();
+        m_saveButton->setVisible(!cancelled);
+        QString message = cancelled ? "Raytracing cancelled." : "Raytracing completed.";
+        if (m_overlapMode && !cancelled) message = showOverlapPairs();
+        if (Globals::mainWindow != nullptr) {
+            Globals::mainWindow->getStatusBar()->showMessage(message, Globals::mainWindow->statusBarShortMessageDuration);
+        }
+    });
+}
+
+
+RaytraceView::~RaytraceView() {
+    delete m_raytracer;
+    delete m_fileWriter;
+}
+
+
+void RaytraceView::closeEvent(QCloseEvent* event) {
+    m_raytracer->cancel();
+    QWidget::closeEvent(event);
 }
 
 
@@ -76,143 +161,177 @@ void RaytraceView::paintEvent
 ) {
 
     QPainter painter(this);
+    if (m_fileWriter != nullptr) {
+        painter.drawText(rect(), Qt::AlignCenter, "Raytracing to " + QFileInfo(windowFilePath()).fileName() + "...");
+        return;
+    }
     painter.drawImage(0, 0, m_image);
 }
 
 
-class RayTraceCallback : public BRLCAD::ConstDatabase::HitCallback {
-public:
-    RayTraceCallback(const QVector3D &direction, const QColor& color)
-            : BRLCAD::ConstDatabase::HitCallback(), m_direction(direction), m_color(color) {}
-
-    virtual bool operator()(const BRLCAD::ConstDatabase::Hit& hit) throw() {
-        double    brightness         = 0;
-        double    ambient            = 0.1;
-        double    diffuseWeight      = 0.5;
-        double    specularWeight     = 0.5;
-        int       n                  = 4;
-        QVector3D normal             = QVector3D(hit.SurfaceNormalIn().coordinates[0], hit.SurfaceNormalIn().coordinates[1], hit.SurfaceNormalIn().coordinates[2]);
-        double    dotProduct         = QVector3D::dotProduct(m_direction, normal); // negative because of opposite directions
+// starts a progressive raytrace, m_image shows the background until the first tiles are done
+void RaytraceView::UpdateImage(int w, int h) {
+    m_image = QImage(w, h, QImage::Format_RGB32);
+    m_image.fill(color);
+    m_progressBar->setValue(0);
+    m_progressBar->show();
+    m_cancelButton->show();
+    m_saveButton->hide();
+    if (m_overlapMode) m_raytraceId = m_raytracer->startOverlaps(m_transformation, w, h, color, m_selectedPaths);
+    else m_raytraceId = m_raytracer->start(m_transformation, w, h, color, m_selectedPaths, true);
+}
 
-        // value from 0 to 1
-        double    diffuse            = -dotProduct;
 
-        // refleced = incidence - 2 normal
-        QVector3D reflectedDir       = m_direction - 2. * dotProduct * normal;
-        reflectedDir.normalize();
+void RaytraceView::saveImage() {
+    const QString filePath = QFileDialog::getSaveFileName(this, tr("Save raytraced image"), QString(), "PNG file (*.png)");
+    if (!filePath.isEmpty()) {
+        m_image.save(filePath);
+    }
+}
 
-        // value from 0 to 1
-        double    reflectedDotCamDir = std::max(0.f, QVector3D::dotProduct(reflectedDir, m_direction));
-        double    specular           = pow(reflectedDotCamDir, n);
 
-        brightness += ambient + diffuse * diffuseWeight;
+void RaytraceView::readSettings() {
+    QSettings settings("BRLCAD", "arbalest");
+    color=settings.value("raytraceBackground").value<QColor>();
+    bool valid = color.isValid();
+    if (!valid) color = Qt::black;
+    m_raytracer->setAntiAliasingEnabled(settings.value("raytraceAntiAliasing", false).toBool());
+}
 
-        double    red                = std::min(hit.Red() * brightness + specular * specularWeight, 1.0);
-        double    green              = std::min(hit.Green() * brightness + specular * specularWeight, 1.0);
-        double    blue               = std::min(hit.Blue() * brightness + specular * specularWeight, 1.0);
 
-        m_color.setRgbF(red, green, blue);
+// maps pixels of a w x h image to the model, showing the current viewport's vertical span
+QMatrix4x4 RaytraceView::viewTransformation(int w, int h) const {
+    OrthographicCamera* camera = document->getDisplay()->getCamera();
+    return Raytracer::viewTransformation(camera->getEyePosition(), camera->getAnglesAroundAxes(),
+                                         camera->getVerticalSpan(), w, h);
+}
 
-        return false;
-    }
 
-    const QColor& Color() const {
-        return m_color;
-    }
+void RaytraceView::raytrace() {
+    m_overlapMode = false;
+    startRaytrace();
+}
 
-private:
-    QVector3D m_direction;
-    QColor    m_color;
-};
 
+void RaytraceView::raytraceOverlaps() {
+    m_overlapMode = true;
+    startRaytrace();
+}
 
-void RaytraceView::UpdateImage() {
-    int w  = width();
-    int h = height();
 
-    m_image = QImage(w, h, QImage::Format_RGB32);
+void RaytraceView::startRaytrace() {
+    // the finished signal of a cancelled file raytrace comes after the next raytrace started, and is ignored then
+    m_raytracer->cancel();
+    if (m_fileWriter != nullptr) fileRaytraceFinished(true);
+    readSettings();
 
-    QVector3D directionStart = m_transformation.map(QVector3D(0., 0., 1.));
-    QVector3D directionEnd   = m_transformation.map(QVector3D(0., 0., 0.));
-    QVector3D direction      = directionEnd - directionStart;
-    direction.normalize();
+    hide();
+    m_selectedPaths = document->getVisibleObjectPaths();
 
-    for (int column = 0; column < w; column++) {
-        for (int row = 0; row < h; row++) {
-            QVector3D        imagePoint(column, h - row - 1., 0.);
-            QVector3D        modelPoint = m_transformation.map(imagePoint);
-            RayTraceCallback callback(direction, color);
-            BRLCAD::Ray3D    ray;
+    m_overlapList->clear();
+    m_overlapList->setVisible(m_overlapMode);
+    resize(document->getDisplay()->getW() + (m_overlapMode ? overlapListWidth : 0),document->getDisplay()->getH());
+    UpdateTrafo(viewTransformation(document->getDisplay()->getW(),document->getDisplay()->getH()));
+    UpdateImage(document->getDisplay()->getW(),document->getDisplay()->getH());
 
-            ray.origin.coordinates[0]    = modelPoint.x();
-            ray.origin.coordinates[1]    = modelPoint.y();
-            ray.origin.coordinates[2]    = modelPoint.z();
-            ray.direction.coordinates[0] = direction.x();
-            ray.direction.coordinates[1] = direction.y();
-            ray.direction.coordinates[2] = direction.z();
+    Update();
+    setWindowTitle(m_overlapMode ? "Overlaps" : "Raytrace");
+    show();
+}
 
-            m_database.ShootRay(ray, callback, BRLCAD::ConstDatabase::StopAfterFirstHit);
 
-            m_image.setPixelColor(column, row, callback.Color());
-        }
-    }
+/*
+ * Identifies what a file raytrace draws, so an interrupted one is only continued if nothing changed. qHash is seeded
+ * per process, the signature has to be the same in the next session. The database is identified by the snapshot the
+ * raytrace traces, as unsaved edits of different sessions can have the same revision.
+ */
+quint64 RaytraceView::fileSignature(const QMatrix4x4& transformation, int w, int h) const {
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << transformation << w << h << color.rgb() << m_selectedPaths << m_raytracer->isAntiAliasingEnabled();
+    stream << m_raytracer->getSnapshotHash();
+
+    const QByteArray hash = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+    quint64 signature;
+    memcpy(&signature, hash.constData(), sizeof(signature));
+    return signature;
 }
 
 
-void RaytraceView::raytrace() {
-    QSettings settings("BRLCAD", "arbalest");
-    color=settings.value("raytraceBackground").value<QColor>();
-    bool valid = color.isValid();
-    if (!valid) color = Qt::black;
+void RaytraceView::raytraceToFile(const QString& filePath, int w, int h) {
+    m_raytracer->cancel();
+    if (m_fileWriter != nullptr) fileRaytraceFinished(true);
+    readSettings();
+    m_selectedPaths = document->getVisibleObjectPaths();
+    const QMatrix4x4 transformation = viewTransformation(w, h);
 
-    hide();
-    document->getDatabase()->UnSelectAll();
-    document->getObjectTree()->traverseSubTree(0, false, [this]
-                                                       (int objectId){
-                                                   switch(document->getObjectTree()->getObjectVisibility()[objectId]){
-                                                       case ObjectTree::Invisible:
-                                                           return false;
-                                                       case ObjectTree::SomeChildrenVisible:
-                                                           return true;
-                                                       case ObjectTree::FullyVisible:
-                                                           QString fullPath = document->getObjectTree()->getFullPathMap()[objectId];
-                                                           document->getDatabase()->Select(fullPath.toUtf8());
-                                                           return false;
-                                                   }
-                                                   return true;
-                                               }
-    );
-
-    QMatrix4x4 transformation;
-    transformation.translate(document->getDisplay()->getCamera()->getEyePosition().x(),
-                             document->getDisplay()->getCamera()->getEyePosition().y(),
-                             document->getDisplay()->getCamera()->getEyePosition().z());
-    transformation.rotate(-document->getDisplay()->getCamera()->getAnglesAroundAxes().y(), 0., 1., 0.);
-    transformation.rotate(-document->getDisplay()->getCamera()->getAnglesAroundAxes().z(), 0., 0., 1.);
-    transformation.rotate(-document->getDisplay()->getCamera()->getAnglesAroundAxes().x(), 1., 0., 0.);
-    transformation.translate(0, 0, 10000);
-    transformation.scale(document->getDisplay()->getCamera()->getVerticalSpan()/document->getDisplay()->getH());
-    transformation.translate(-document->getDisplay()->getW()/2.,-document->getDisplay()->getH()/2.);
-
-    resize(document->getDisplay()->getW(),document->getDisplay()->getH());
-    UpdateTrafo(transformation);
-    UpdateImage();
+    m_fileWriter = new TiledTiffWriter(filePath, w, h, m_raytracer->getTileSize(), fileSignature(transformation, w, h));
+    if (!m_fileWriter->open()) {
+        QMessageBox::warning(this, "Raytrace to file", "Could not write " + filePath + ":\n" + m_fileWriter->getErrorString());
+        delete m_fileWriter;
+        m_fileWriter = nullptr;
+        return;
+    }
+    if (m_fileWriter->isResumed() && Globals::mainWindow != nullptr) {
+        Globals::mainWindow->getStatusBar()->showMessage("Continuing the raytrace of " + QFileInfo(filePath).fileName() + ".",
+                                                         Globals::mainWindow->statusBarShortMessageDuration);
+    }
 
-    Update();
-    setWindowTitle("Raytrace");
+    m_image = QImage();
+    m_overlapMode = false;
+    m_overlapList->hide();
+    m_progressBar->setMaximum(m_fileWriter->getTileCount());
+    m_progressBar->setValue(m_fileWriter->getWrittenTileCount());
+    m_progressBar->show();
+    m_cancelButton->show();
+    m_saveButton->hide();
+    setWindowFilePath(filePath);
+    setWindowTitle("Raytrace to file");
+    resize(400, 100);
     show();
+    m_raytraceId = m_raytracer->startToFile(transformation, color, m_selectedPaths, m_fileWriter);
+}
 
 
+// a cancelled file raytrace keeps its progress, raytracing the same view into the same file continues it
+void RaytraceView::fileRaytraceFinished(bool cancelled) {
+    QString message;
+    if (m_fileWriter->finish()) {
+        message = "Raytraced image written to " + windowFilePath() + ".";
+    }
+    else if (!m_fileWriter->getErrorString().isEmpty()) {
+        message = "Raytracing to file failed: " + m_fileWriter->getErrorString();
+    }
+    else {
+        message = cancelled ? "Raytracing cancelled, raytrace the same view to the same file again to continue."
+                            : "Raytracing to file failed.";
+    }
+    delete m_fileWriter;
+    m_fileWriter = nullptr;
+
+    m_progressBar->hide();
+    m_cancelButton->hide();
+    update();
+    if (Globals::mainWindow != nullptr) {
+        Globals::mainWindow->getStatusBar()->showMessage(message, Globals::mainWindow->statusBarShortMessageDuration);
+    }
+}
 
-    QMessageBox::StandardButton reply;
-    reply = QMessageBox::question(this, "Save?", "Do you want to save the raytraced image?",  QMessageBox::Yes|QMessageBox::No);
-    if (reply == QMessageBox::Yes) {
-        const QString filePath = QFileDialog::getSaveFileName(this, tr("Save raytraced image"), QString(), "PNG file (*.png)");
-        if (!filePath.isEmpty()) {
-            m_image.save(filePath);
-        }
-    } else {
 
+// lists the largest overlaps, gqa's overlaps test on these regions tells how bad they are
+QString RaytraceView::showOverlapPairs() {
+    const QVector<Raytracer::OverlapPair> pairs = m_raytracer->getOverlapPairs();
+    m_overlapList->clear();
+    for (int i = 0; i < std::min(pairs.size(), maxOverlapPairs); i++) {
+        QTreeWidgetItem* item = new QTreeWidgetItem(m_overlapList);
+        item->setText(0, pairs[i].region1 + "\n" + pairs[i].region2);
+        item->setToolTip(0, pairs[i].region1 + "\n" + pairs[i].region2);
+        item->setText(1, QString::number(pairs[i].volume, 'g', 3));
+        item->setText(2, QString::number(pairs[i].maxDepth, 'g', 3));
+        item->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+        item->setTextAlignment(2, Qt::AlignRight | Qt::AlignVCenter);
     }
 
+    if (pairs.isEmpty()) return "No overlaps found in the current viewport.";
+    return QString::number(pairs.size()) + " overlapping region pairs found in the current viewport.";
 }
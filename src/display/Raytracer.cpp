@@ -0,0 +1,586 @@
+/*                      R A Y T R A C E R . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file Raytracer.cpp */
+
+#include <algorithm>
+#include <cmath>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QRunnable>
+#include <QThread>
+#include <brlcad/MemoryDatabase.h>
+#include "Raytracer.h"
+#include "Document.h"
+#include "TiledTiffWriter.h"
+
+
+class RaytraceTask : public QRunnable {
+public:
+    RaytraceTask(Raytracer* raytracer, int workerIndex) : raytracer(raytracer), workerIndex(workerIndex) {}
+
+    void run() override
+    {
+        raytracer->work(workerIndex);
+    }
+
+private:
+    Raytracer* raytracer;
+    int workerIndex;
+};
+
+// runs a whole raytrace, so start() does not wait for the passes
+class RaytraceJobTask : public QRunnable {
+public:
+    explicit RaytraceJobTask(Raytracer* raytracer) : raytracer(raytracer) {}
+
+    void run() override
+    {
+        raytracer->runJob();
+    }
+
+private:
+    Raytracer* raytracer;
+};
+
+namespace {
+    // rotated grid offsets of the extra rays of an edge pixel, in pixels from the primary ray
+    const float subSampleOffsets[][2] = {{-.375f, -.125f}, {.125f, -.375f}, {.375f, .125f}, {-.125f, .375f}};
+    const int subSampleCount = 4;
+
+    // records the first hit of a ray into a RayHits, and with segments all hits of the ray. Reset and reused for
+    // every ray of a worker
+    class RayTraceCallback : public BRLCAD::ConstDatabase::HitCallback {
+    public:
+        void reset(RayHits* hits, int index, QVector<QPair<QByteArray, QPair<double, double>>>* segments = nullptr)
+        {
+            m_hits = hits;
+            m_index = index;
+            m_segments = segments;
+            m_first = true;
+            m_hits->setMissed(index);
+            if (m_segments != nullptr) m_segments->clear();
+        }
+
+        bool operator()(const BRLCAD::ConstDatabase::Hit& hit) throw() override
+        {
+            const QByteArray name(hit.Name());
+            if (m_first) {
+                const QVector3D normal(hit.SurfaceNormalIn().coordinates[0], hit.SurfaceNormalIn().coordinates[1],
+                                       hit.SurfaceNormalIn().coordinates[2]);
+                // 0 is the background
+                const quint32 region = std::max(qHash(name), 1u);
+                m_hits->set(m_index, normal, hit.Red(), hit.Green(), hit.Blue(), hit.DistanceIn(), region);
+                m_first = false;
+            }
+            if (m_segments == nullptr) return false;
+            m_segments->append(qMakePair(name, qMakePair(hit.DistanceIn(), hit.DistanceOut())));
+            return true;
+        }
+
+    private:
+        RayHits* m_hits = nullptr;
+        int      m_index = 0;
+        QVector<QPair<QByteArray, QPair<double, double>>>* m_segments = nullptr;
+        bool     m_first = true;
+    };
+}
+
+
+Raytracer::Raytracer(Document* document, QObject* parent) : QObject(parent), document(document)
+{
+    workers.resize(QThread::idealThreadCount());
+    threadPool.setMaxThreadCount(workers.size());
+    jobPool.setMaxThreadCount(1);
+}
+
+Raytracer::~Raytracer()
+{
+    cancel();
+    for (Worker& worker : workers) delete worker.database;
+}
+
+// The snapshot is written on the thread that starts the raytrace, as the document is not to be used from the job.
+// The worker databases are loaded by the workers, here they are only dropped if the document changed
+void Raytracer::updateSnapshot()
+{
+    if (!snapshotPath.isEmpty() && workersDatabaseRevision == document->getDatabaseRevision()) return;
+
+    for (Worker& worker : workers) {
+        delete worker.database;
+        worker.database = nullptr;
+        worker.selectionSignature = 0;
+    }
+    snapshotPath = snapshotDirectory.filePath("snapshot.g");
+    snapshotHash.clear();
+    QFile snapshot(snapshotPath);
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    if (!snapshotDirectory.isValid() || !document->saveCopy(snapshotPath) || !snapshot.open(QIODevice::ReadOnly) ||
+        !hash.addData(&snapshot)) {
+        qWarning("Raytracer: failed to write a snapshot of the database");
+        snapshotPath.clear();
+    }
+    else {
+        snapshotHash = hash.result();
+    }
+    workersDatabaseRevision = document->getDatabaseRevision();
+}
+
+QByteArray Raytracer::getSnapshotHash()
+{
+    updateSnapshot();
+    return snapshotHash;
+}
+
+void Raytracer::setAntiAliasingEnabled(const bool enabled)
+{
+    antiAliasingEnabled = enabled;
+}
+
+quint64 Raytracer::start(const QMatrix4x4& transformation, const int w, const int h, const QColor& background,
+                         const QStringList& selectedPaths, const bool progressive)
+{
+    cancel();
+    this->progressive = progressive;
+    overlaps = false;
+    writer = nullptr;
+    createImage(w, h, background);
+    return startJob(transformation, image.width(), image.height(), background, selectedPaths);
+}
+
+quint64 Raytracer::startToFile(const QMatrix4x4& transformation, const QColor& background,
+                               const QStringList& selectedPaths, TiledTiffWriter* writer)
+{
+    cancel();
+    progressive = false;
+    overlaps = false;
+    this->writer = writer;
+    image = QImage();
+    bits = nullptr;
+    bytesPerLine = 0;
+    return startJob(transformation, writer->getWidth(), writer->getHeight(), background, selectedPaths);
+}
+
+quint64 Raytracer::startOverlaps(const QMatrix4x4& transformation, const int w, const int h,
+                                 const QColor& background, const QStringList& selectedPaths)
+{
+    cancel();
+    // the heat map comes in tile by tile
+    progressive = true;
+    overlaps = true;
+    writer = nullptr;
+    createImage(w, h, background);
+    return startJob(transformation, image.width(), image.height(), background, selectedPaths);
+}
+
+QVector<Raytracer::OverlapPair> Raytracer::getOverlapPairs() const
+{
+    QHash<QPair<QByteArray, QByteArray>, OverlapPair> pairs;
+    for (const Worker& worker : workers) {
+        for (auto it = worker.overlapPairs.constBegin(); it != worker.overlapPairs.constEnd(); ++it) {
+            OverlapPair& pair = pairs[it.key()];
+            pair.region1 = it.value().region1;
+            pair.region2 = it.value().region2;
+            pair.rayCount += it.value().rayCount;
+            pair.maxDepth = std::max(pair.maxDepth, it.value().maxDepth);
+            pair.volume += it.value().volume;
+        }
+    }
+
+    QVector<OverlapPair> result;
+    for (const OverlapPair& pair : pairs) result.append(pair);
+    std::sort(result.begin(), result.end(), [](const OverlapPair& a, const OverlapPair& b) {
+        return a.volume > b.volume;
+    });
+    return result;
+}
+
+void Raytracer::createImage(const int w, const int h, const QColor& background)
+{
+    image = QImage(std::max(w, 0), std::max(h, 0), QImage::Format_RGB32);
+    image.fill(background.rgb());
+    bits = image.bits();
+    bytesPerLine = image.bytesPerLine();
+}
+
+quint64 Raytracer::startJob(const QMatrix4x4& transformation, const int w, const int h, const QColor& background,
+                            const QStringList& selectedPaths)
+{
+    cancelled = 0;
+    raytraceId++;
+    antiAliasing = antiAliasingEnabled;
+    this->background = background.rgb();
+    this->w = w;
+    this->h = h;
+    tilesPerRow = (this->w + tileSize - 1) / tileSize;
+    tileCount = tilesPerRow * ((this->h + tileSize - 1) / tileSize);
+    this->selectedPaths = selectedPaths;
+    this->selectedPaths.sort();
+    selectionSignature = Document::selectionSignature(selectedPaths, document->getDatabaseRevision());
+
+    // the transformation is affine, so the ray origins of a row are a start point plus multiples of a step
+    origin = transformation.map(QVector3D(0., h - 1., 0.));
+    rightStep = transformation.map(QVector3D(1., h - 1., 0.)) - origin;
+    downStep = transformation.map(QVector3D(0., h - 2., 0.)) - origin;
+    direction = (transformation.map(QVector3D(0., 0., 0.)) - transformation.map(QVector3D(0., 0., 1.))).normalized();
+    edgeDepth = edgeDepthPixels * rightStep.length();
+
+    updateSnapshot();
+    jobPool.start(new RaytraceJobTask(this));
+    return raytraceId;
+}
+
+QMatrix4x4 Raytracer::viewTransformation(const QVector3D& eyePosition, const QVector3D& anglesAroundAxes,
+                                         const double verticalSpan, const int w, const int h)
+{
+    QMatrix4x4 transformation;
+    transformation.translate(eyePosition);
+    transformation.rotate(-anglesAroundAxes.y(), 0., 1., 0.);
+    transformation.rotate(-anglesAroundAxes.z(), 0., 0., 1.);
+    transformation.rotate(-anglesAroundAxes.x(), 1., 0., 0.);
+    // rays start in front of the model
+    transformation.translate(0, 0, 10000);
+    transformation.scale(verticalSpan / h);
+    transformation.translate(-w / 2., -h / 2.);
+    return transformation;
+}
+
+void Raytracer::cancel()
+{
+    cancelled = 1;
+    jobPool.waitForDone();
+}
+
+bool Raytracer::isRunning() const
+{
+    return jobPool.activeThreadCount() > 0;
+}
+
+QImage Raytracer::render(const QMatrix4x4& transformation, const int w, const int h, const QColor& background,
+                         const QStringList& selectedPaths)
+{
+    start(transformation, w, h, background, selectedPaths, false);
+    jobPool.waitForDone();
+    return image;
+}
+
+void Raytracer::runJob()
+{
+    for (Worker& worker : workers) worker.overlapPairs.clear();
+    if (!snapshotPath.isEmpty() && tileCount > 0) {
+        if (overlaps) {
+            runPass(overlapBlockSize);
+        }
+        else {
+            if (progressive) runPass(coarseBlockSize);
+            runPass(1);
+        }
+    }
+    emit finished(raytraceId, cancelled.loadAcquire() != 0);
+}
+
+void Raytracer::runPass(const int blockSize)
+{
+    if (cancelled.loadAcquire() != 0) return;
+    this->blockSize = blockSize;
+    nextTile = 0;
+    finishedTileCount = writer != nullptr ? writer->getWrittenTileCount() : 0;
+    for (int i = 0; i < workers.size(); i++) threadPool.start(new RaytraceTask(this, i));
+    threadPool.waitForDone();
+}
+
+void Raytracer::work(const int workerIndex)
+{
+    Worker& worker = workers[workerIndex];
+    if (worker.database == nullptr) {
+        // cancel() waits for the workers, so the ones still queued for the load mutex give up right away
+        if (cancelled.loadAcquire() != 0) return;
+        QMutexLocker locker(&loadMutex);
+        if (cancelled.loadAcquire() != 0) return;
+        worker.database = new BRLCAD::MemoryDatabase();
+        if (!worker.database->Load(snapshotPath.toUtf8())) {
+            qWarning("Raytracer: failed to load the database snapshot");
+            delete worker.database;
+            worker.database = nullptr;
+            return;
+        }
+    }
+    // a worker database is loaded again when the document changes, so the paths tell whether it selected the same
+    if (worker.selectionSignature != selectionSignature || worker.selectedPaths != selectedPaths) {
+        worker.database->UnSelectAll();
+        for (const QString& path : selectedPaths) worker.database->Select(path.toUtf8());
+        worker.selectionSignature = selectionSignature;
+        worker.selectedPaths = selectedPaths;
+    }
+
+    for (int tile = nextTile.fetchAndAddRelaxed(1); tile < tileCount; tile = nextTile.fetchAndAddRelaxed(1)) {
+        if (cancelled.loadAcquire() != 0) return;
+        if (writer != nullptr && writer->isTileWritten(tile)) continue;
+        if (overlaps) traceOverlapTile(worker, tile);
+        else traceTile(worker, tile);
+    }
+}
+
+bool Raytracer::isEdge(const RayHits& hits, const int sample, const int neighbor) const
+{
+    if (hits.region[sample] != hits.region[neighbor]) return true;
+    if (hits.region[sample] == 0) return false;
+    const float normalCosine = hits.normalX[sample] * hits.normalX[neighbor] +
+                               hits.normalY[sample] * hits.normalY[neighbor] +
+                               hits.normalZ[sample] * hits.normalZ[neighbor];
+    if (normalCosine < edgeNormalCosine) return true;
+    return std::abs(hits.depth[sample] - hits.depth[neighbor]) > edgeDepth;
+}
+
+/*
+ * The rays of a tile are shot first, recording their hits in worker.hits, and then shaded together. The coarse pass
+ * shoots one ray per block. The full resolution pass shoots one per pixel, and with anti-aliasing one for each pixel
+ * of a ring around the tile as well, so each pixel can be compared with its four neighbors. Pixels where the region,
+ * the surface normal or the depth changes get subSampleCount more rays, averaged with the first.
+ *
+ * When writing to a file, the tile is traced into the worker's tileImage and handed to the writer.
+ */
+void Raytracer::traceTile(Worker& worker, const int tile)
+{
+    const int left = (tile % tilesPerRow) * tileSize;
+    const int top = (tile / tilesPerRow) * tileSize;
+    const int right = std::min(left + tileSize, w);
+    const int bottom = std::min(top + tileSize, h);
+
+    // the pixel at column, row is at line(row)[column - targetLeft]
+    uchar* targetBits = bits;
+    int targetBytesPerLine = bytesPerLine;
+    int targetLeft = 0;
+    int targetTop = 0;
+    if (writer != nullptr) {
+        if (worker.tileImage.isNull()) worker.tileImage = QImage(tileSize, tileSize, QImage::Format_RGB32);
+        targetBits = worker.tileImage.bits();
+        targetBytesPerLine = worker.tileImage.bytesPerLine();
+        targetLeft = left;
+        targetTop = top;
+    }
+    const auto line = [&](const int row) {
+        return reinterpret_cast<QRgb*>(targetBits + (row - targetTop) * targetBytesPerLine);
+    };
+
+    const BRLCAD::MemoryDatabase& database = *worker.database;
+    RayTraceCallback callback;
+    BRLCAD::Ray3D ray;
+    ray.direction.coordinates[0] = direction.x();
+    ray.direction.coordinates[1] = direction.y();
+    ray.direction.coordinates[2] = direction.z();
+    const auto trace = [&](const float column, const float row, RayHits& hits, const int index) {
+        const QVector3D modelPoint = origin + row * downStep + column * rightStep;
+        ray.origin.coordinates[0] = modelPoint.x();
+        ray.origin.coordinates[1] = modelPoint.y();
+        ray.origin.coordinates[2] = modelPoint.z();
+        callback.reset(&hits, index);
+        database.ShootRay(ray, callback, BRLCAD::ConstDatabase::StopAfterFirstHit);
+    };
+
+    if (blockSize > 1) {
+        // the ray of a block's top left pixel colors the whole block
+        const int blocksPerRow = (right - left + blockSize - 1) / blockSize;
+        const int blockCount = blocksPerRow * ((bottom - top + blockSize - 1) / blockSize);
+        worker.hits.resize(blockCount);
+        worker.colors.resize(blockCount);
+        for (int block = 0; block < blockCount; block++) {
+            trace(left + (block % blocksPerRow) * blockSize, top + (block / blocksPerRow) * blockSize, worker.hits,
+                  block);
+        }
+        shadeHits(worker.hits, blockCount, direction, background, worker.colors.data());
+
+        for (int row = top; row < bottom; row++) {
+            QRgb* pixels = line(row);
+            const QRgb* blockColors = worker.colors.constData() + (row - top) / blockSize * blocksPerRow;
+            for (int column = left; column < right; column++) {
+                pixels[column - targetLeft] = blockColors[(column - left) / blockSize];
+            }
+        }
+    }
+    else {
+        const int ring = antiAliasing ? 1 : 0;
+        const int samplesLeft = left - ring;
+        const int samplesTop = top - ring;
+        const int samplesPerRow = right - left + 2 * ring;
+        const int sampleCount = samplesPerRow * (bottom - top + 2 * ring);
+        const auto sampleIndex = [=](const int column, const int row) {
+            return (row - samplesTop) * samplesPerRow + column - samplesLeft;
+        };
+
+        worker.hits.resize(sampleCount);
+        worker.colors.resize(sampleCount);
+        for (int row = samplesTop; row < bottom + ring; row++) {
+            for (int column = samplesLeft; column < right + ring; column++) {
+                trace(column, row, worker.hits, sampleIndex(column, row));
+            }
+        }
+        shadeHits(worker.hits, sampleCount, direction, background, worker.colors.data());
+
+        for (int row = top; row < bottom; row++) {
+            QRgb* pixels = line(row);
+            for (int column = left; column < right; column++) {
+                pixels[column - targetLeft] = worker.colors[sampleIndex(column, row)];
+            }
+        }
+
+        if (antiAliasing) {
+            worker.edgePixels.clear();
+            for (int row = top; row < bottom; row++) {
+                for (int column = left; column < right; column++) {
+                    const int sample = sampleIndex(column, row);
+                    if (isEdge(worker.hits, sample, sample - 1) || isEdge(worker.hits, sample, sample + 1) ||
+                        isEdge(worker.hits, sample, sample - samplesPerRow) ||
+                        isEdge(worker.hits, sample, sample + samplesPerRow)) {
+                        worker.edgePixels.append(sample);
+                    }
+                }
+            }
+
+            const int subSampleTotal = worker.edgePixels.size() * subSampleCount;
+            worker.subSampleHits.resize(subSampleTotal);
+            worker.subSampleColors.resize(subSampleTotal);
+            for (int i = 0; i < worker.edgePixels.size(); i++) {
+                const int column = samplesLeft + worker.edgePixels[i] % samplesPerRow;
+                const int row = samplesTop + worker.edgePixels[i] / samplesPerRow;
+                for (int j = 0; j < subSampleCount; j++) {
+                    trace(column + subSampleOffsets[j][0], row + subSampleOffsets[j][1], worker.subSampleHits,
+                          i * subSampleCount + j);
+                }
+            }
+            shadeHits(worker.subSampleHits, subSampleTotal, direction, background, worker.subSampleColors.data());
+
+            const int count = 1 + subSampleCount;
+            for (int i = 0; i < worker.edgePixels.size(); i++) {
+                const QRgb color = worker.colors[worker.edgePixels[i]];
+                int red = qRed(color);
+                int green = qGreen(color);
+                int blue = qBlue(color);
+                for (int j = 0; j < subSampleCount; j++) {
+                    const QRgb subSampleColor = worker.subSampleColors[i * subSampleCount + j];
+                    red += qRed(subSampleColor);
+                    green += qGreen(subSampleColor);
+                    blue += qBlue(subSampleColor);
+                }
+                const int column = samplesLeft + worker.edgePixels[i] % samplesPerRow;
+                const int row = samplesTop + worker.edgePixels[i] / samplesPerRow;
+                line(row)[column - targetLeft] = qRgb((red + count / 2) / count, (green + count / 2) / count,
+                                                      (blue + count / 2) / count);
+            }
+        }
+    }
+
+    if (writer != nullptr && !writer->writeTile(tile, worker.tileImage)) {
+        // the job ends as cancelled, the writer has the error
+        cancelled = 1;
+        return;
+    }
+    if (progressive) {
+        const QRect rect(left, top, right - left, bottom - top);
+        emit tileFinished(raytraceId, rect, image.copy(rect));
+    }
+    if (blockSize == 1) emit progressChanged(raytraceId, finishedTileCount.fetchAndAddRelaxed(1) + 1, tileCount);
+}
+
+/*
+ * Each block's ray collects the segments of all regions it passes through. Any two segments of different regions
+ * that intersect are an overlap, the block shows their summed depth on a yellow to red scale. Blocks without overlaps
+ * show the shaded model in dim gray.
+ */
+void Raytracer::traceOverlapTile(Worker& worker, const int tile)
+{
+    const int left = (tile % tilesPerRow) * tileSize;
+    const int top = (tile / tilesPerRow) * tileSize;
+    const int right = std::min(left + tileSize, w);
+    const int bottom = std::min(top + tileSize, h);
+    const int blocksPerRow = (right - left + blockSize - 1) / blockSize;
+    const int blockCount = blocksPerRow * ((bottom - top + blockSize - 1) / blockSize);
+    const double pixelWidth = rightStep.length();
+    const double blockArea = pixelWidth * pixelWidth * blockSize * blockSize;
+
+    const BRLCAD::MemoryDatabase& database = *worker.database;
+    RayTraceCallback callback;
+    BRLCAD::Ray3D ray;
+    ray.direction.coordinates[0] = direction.x();
+    ray.direction.coordinates[1] = direction.y();
+    ray.direction.coordinates[2] = direction.z();
+
+    worker.hits.resize(blockCount);
+    worker.colors.resize(blockCount);
+    worker.overlapDepths.resize(blockCount);
+    for (int block = 0; block < blockCount; block++) {
+        const QVector3D modelPoint = origin + (top + (block / blocksPerRow) * blockSize) * downStep +
+                                     (left + (block % blocksPerRow) * blockSize) * rightStep;
+        ray.origin.coordinates[0] = modelPoint.x();
+        ray.origin.coordinates[1] = modelPoint.y();
+        ray.origin.coordinates[2] = modelPoint.z();
+        callback.reset(&worker.hits, block, &worker.segments);
+        database.ShootRay(ray, callback, BRLCAD::ConstDatabase::WithOverlaps);
+
+        double depth = 0.;
+        for (int i = 0; i < worker.segments.size(); i++) {
+            for (int j = i + 1; j < worker.segments.size(); j++) {
+                const QByteArray& name1 = worker.segments[i].first;
+                const QByteArray& name2 = worker.segments[j].first;
+                if (name1 == name2) continue;
+                const double overlap = std::min(worker.segments[i].second.second, worker.segments[j].second.second) -
+                                       std::max(worker.segments[i].second.first, worker.segments[j].second.first);
+                if (overlap <= overlapTolerance) continue;
+
+                depth += overlap;
+                const QPair<QByteArray, QByteArray> key = name1 < name2 ? qMakePair(name1, name2)
+                                                                        : qMakePair(name2, name1);
+                OverlapPair& pair = worker.overlapPairs[key];
+                if (pair.rayCount == 0) {
+                    pair.region1 = QString::fromUtf8(key.first);
+                    pair.region2 = QString::fromUtf8(key.second);
+                }
+                pair.rayCount++;
+                pair.maxDepth = std::max(pair.maxDepth, overlap);
+                pair.volume += overlap * blockArea;
+            }
+        }
+        worker.overlapDepths[block] = static_cast<float>(depth);
+    }
+    shadeHits(worker.hits, blockCount, direction, background, worker.colors.data());
+
+    // logarithmic, so thin overlaps stand out as well
+    const float saturation = std::log(1.f + overlapSaturationPixels);
+    for (int block = 0; block < blockCount; block++) {
+        const float depth = worker.overlapDepths[block];
+        if (depth > 0.f) {
+            const float heat = std::min(std::log(1.f + depth / static_cast<float>(pixelWidth)) / saturation, 1.f);
+            worker.colors[block] = qRgb(255, static_cast<int>(255.f * (1.f - heat)), 0);
+        }
+        else if (worker.hits.region[block] != 0) {
+            const int gray = qGray(worker.colors[block]) / 3;
+            worker.colors[block] = qRgb(gray, gray, gray);
+        }
+    }
+
+    for (int row = top; row < bottom; row++) {
+        QRgb* line = reinterpret_cast<QRgb*>(bits + row * bytesPerLine);
+        const QRgb* blockColors = worker.colors.constData() + (row - top) / blockSize * blocksPerRow;
+        for (int column = left; column < right; column++) line[column] = blockColors[(column - left) / blockSize];
+    }
+
+    const QRect rect(left, top, right - left, bottom - top);
+    emit tileFinished(raytraceId, rect, image.copy(rect));
+    emit progressChanged(raytraceId, finishedTileCount.fetchAndAddRelaxed(1) + 1, tileCount);
+}
@@ -0,0 +1,59 @@
+/*                    V I E W F R U S T U M . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file ViewFrustum.cpp */
+
+#include "ViewFrustum.h"
+
+
+// Gribb & Hartmann: each plane is the sum or difference of the last row of the matrix and one of the others
+ViewFrustum::ViewFrustum(const QMatrix4x4& viewProjection)
+{
+    const QVector4D rowX = viewProjection.row(0);
+    const QVector4D rowY = viewProjection.row(1);
+    const QVector4D rowZ = viewProjection.row(2);
+    const QVector4D rowW = viewProjection.row(3);
+
+    planes[0] = rowW + rowX;
+    planes[1] = rowW - rowX;
+    planes[2] = rowW + rowY;
+    planes[3] = rowW - rowY;
+    planes[4] = rowW + rowZ;
+    planes[5] = rowW - rowZ;
+}
+
+ViewFrustum::Intersection ViewFrustum::intersect(const AxisAlignedBox& box) const
+{
+    if (box.isEmpty()) return Outside;
+
+    Intersection result = Inside;
+    for (const QVector4D& plane : planes) {
+        // the corners of the box furthest along and against the plane normal
+        const QVector3D positive(plane.x() >= 0 ? box.maximum.x() : box.minimum.x(),
+                                 plane.y() >= 0 ? box.maximum.y() : box.minimum.y(),
+                                 plane.z() >= 0 ? box.maximum.z() : box.minimum.z());
+        const QVector3D negative(plane.x() >= 0 ? box.minimum.x() : box.maximum.x(),
+                                 plane.y() >= 0 ? box.minimum.y() : box.maximum.y(),
+                                 plane.z() >= 0 ? box.minimum.z() : box.maximum.z());
+
+        if (QVector3D::dotProduct(plane.toVector3D(), positive) + plane.w() < 0) return Outside;
+        if (QVector3D::dotProduct(plane.toVector3D(), negative) + plane.w() < 0) result = Intersecting;
+    }
+    return result;
+}
@@ -43,9 +43,7 @@ DisplayGrid::DisplayGrid(Document*  document) : document(document) {
 }
 
 void DisplayGrid::forceRerenderAllDisplays() {
-    for (Display *display : displays){
-        display->forceRerenderFrame();
-    }
+    document->getFrameScheduler()->requestAllFrames();
 }
 
 void DisplayGrid::setActiveDisplay(Display *display) {
@@ -152,7 +152,7 @@ void MainWindow::prepareUi() {
         BRLCAD::Arb8 * object = new BRLCAD::Arb8();
         object->SetName(name.toUtf8());
         documents[activeDocumentId]->Add(*object);
-        int objectId = documents[activeDocumentId]->getObjectTree()->addTopObject(name);
+        int objectId = documents[activeDocumentId]->addTopObject(name);
         documents[activeDocumentId]->getObjectTree()->changeVisibilityState(objectId,true);
         documents[activeDocumentId]->getObjectTreeWidget()->build(objectId);
         documents[activeDocumentId]->getObjectTreeWidget()->refreshItemTextColors();
@@ -170,7 +170,7 @@ void MainWindow::prepareUi() {
         BRLCAD::Cone * object = new BRLCAD::Cone();
         object->SetName(name.toUtf8());
         documents[activeDocumentId]->Add(*object);
-        int objectId = documents[activeDocumentId]->getObjectTree()->addTopObject(name);
+        int objectId = documents[activeDocumentId]->addTopObject(name);
         documents[activeDocumentId]->getObjectTree()->changeVisibilityState(objectId,true);
         documents[activeDocumentId]->getObjectTreeWidget()->build(objectId);
         documents[activeDocumentId]->getObjectTreeWidget()->refreshItemTextColors();
@@ -191,7 +191,7 @@ void MainWindow::prepareUi() {
         BRLCAD::Ellipsoid * object = new BRLCAD::Ellipsoid();
         object->SetName(name.toUtf8());
         documents[activeDocumentId]->Add(*object);
-        int objectId = documents[activeDocumentId]->getObjectTree()->addTopObject(name);
+        int objectId = documents[activeDocumentId]->addTopObject(name);
         documents[activeDocumentId]->getObjectTree()->changeVisibilityState(objectId,true);
         documents[activeDocumentId]->getObjectTreeWidget()->build(objectId);
         documents[activeDocumentId]->getObjectTreeWidget()->refreshItemTextColors();
@@ -210,7 +210,7 @@ void MainWindow::prepareUi() {
         BRLCAD::EllipticalTorus * object = new BRLCAD::EllipticalTorus();
         object->SetName(name.toUtf8());
         documents[activeDocumentId]->Add(*object);
-        int objectId = documents[activeDocumentId]->getObjectTree()->addTopObject(name);
+        int objectId = documents[activeDocumentId]->addTopObject(name);
         documents[activeDocumentId]->getObjectTree()->changeVisibilityState(objectId,true);
         documents[activeDocumentId]->getObjectTreeWidget()->build(objectId);
         documents[activeDocumentId]->getObjectTreeWidget()->refreshItemTextColors();
@@ -230,7 +230,7 @@ void MainWindow::prepareUi() {
         BRLCAD::Halfspace * object = new BRLCAD::Halfspace();
         object->SetName(name.toUtf8());
         documents[activeDocumentId]->Add(*object);
-        int objectId = documents[activeDocumentId]->getObjectTree()->addTopObject(name);
+        int objectId = documents[activeDocumentId]->addTopObject(name);
         documents[activeDocumentId]->getObjectTree()->changeVisibilityState(objectId,true);
         documents[activeDocumentId]->getObjectTreeWidget()->build(objectId);
         documents[activeDocumentId]->getObjectTreeWidget()->refreshItemTextColors();
@@ -250,7 +250,7 @@ void MainWindow::prepareUi() {
         BRLCAD::HyperbolicCylinder * object = new BRLCAD::HyperbolicCylinder();
         object->SetName(name.toUtf8());
         documents[activeDocumentId]->Add(*object);
-        int objectId = documents[activeDocumentId]->getObjectTree()->addTopObject(name);
+        int objectId = documents[activeDocumentId]->addTopObject(name);
         documents[activeDocumentId]->getObjectTree()->changeVisibilityState(objectId,true);
         documents[activeDocumentId]->getObjectTreeWidget()->build(objectId);
         documents[activeDocumentId]->getObjectTreeWidget()->refreshItemTextColors();
@@ -270,7 +270,7 @@ void MainWindow::prepareUi() {
         BRLCAD::Hyperboloid * object = new BRLCAD::Hyperboloid();
         object->SetName(name.toUtf8());
         documents[activeDocumentId]->Add(*object);
-        int objectId = documents[activeDocumentId]->getObjectTree()->addTopObject(name);
+        int objectId = documents[activeDocumentId]->addTopObject(name);
         documents[activeDocumentId]->getObjectTree()->changeVisibilityState(objectId,true);
         documents[activeDocumentId]->getObjectTreeWidget()->build(objectId);
         documents[activeDocumentId]->getObjectTreeWidget()->refreshItemTextColors();
@@ -291,7 +291,7 @@ void MainWindow::prepareUi() {
         BRLCAD::ParabolicCylinder * object = new BRLCAD::ParabolicCylinder();
         object->SetName(name.toUtf8());
         documents[activeDocumentId]->Add(*object);
-        int objectId = documents[activeDocumentId]->getObjectTree()->addTopObject(name);
+        int objectId = documents[activeDocumentId]->addTopObject(name);
         documents[activeDocumentId]->getObjectTree()->changeVisibilityState(objectId,true);
         documents[activeDocumentId]->getObjectTreeWidget()->build(objectId);
         documents[activeDocumentId]->getObjectTreeWidget()->refreshItemTextColors();
@@ -312,7 +312,7 @@ void MainWindow::prepareUi() {
         BRLCAD::Paraboloid * object = new BRLCAD::Paraboloid();
         object->SetName(name.toUtf8());
         documents[activeDocumentId]->Add(*object);
-        int objectId = documents[activeDocumentId]->getObjectTree()->addTopObject(name);
+        int objectId = documents[activeDocumentId]->addTopObject(name);
         documents[activeDocumentId]->getObjectTree()->changeVisibilityState(objectId,true);
         documents[activeDocumentId]->getObjectTreeWidget()->build(objectId);
         documents[activeDocumentId]->getObjectTreeWidget()->refreshItemTextColors();
@@ -332,7 +332,7 @@ void MainWindow::prepareUi() {
         BRLCAD::Particle * object = new BRLCAD::Particle();
         object->SetName(name.toUtf8());
         documents[activeDocumentId]->Add(*object);
-        int objectId = documents[activeDocumentId]->getObjectTree()->addTopObject(name);
+        int objectId = documents[activeDocumentId]->addTopObject(name);
         documents[activeDocumentId]->getObjectTree()->changeVisibilityState(objectId,true);
         documents[activeDocumentId]->getObjectTreeWidget()->build(objectId);
         documents[activeDocumentId]->getObjectTreeWidget()->refreshItemTextColors();
@@ -351,7 +351,7 @@ void MainWindow::prepareUi() {
         BRLCAD::Torus * object = new BRLCAD::Torus();
         object->SetName(name.toUtf8());
         documents[activeDocumentId]->Add(*object);
-        int objectId = documents[activeDocumentId]->getObjectTree()->addTopObject(name);
+        int objectId = documents[activeDocumentId]->addTopObject(name);
         documents[activeDocumentId]->getObjectTree()->changeVisibilityState(objectId,true);
         documents[activeDocumentId]->getObjectTreeWidget()->build(objectId);
         documents[activeDocumentId]->getObjectTreeWidget()->refreshItemTextColors();
@@ -509,6 +509,65 @@ void MainWindow::prepareUi() {
     });
     viewMenu->addAction(toggleGridAct);
 
+    QAction* toggleShadedAct = new QAction(tr("Toggle shaded mode on/off"), this);
+    toggleShadedAct->setCheckable(true);
+    toggleShadedAct->setShortcut(Qt::Key_S);
+    toggleShadedAct->setStatusTip(tr("Draw the surfaces of objects in their region colors instead of wireframes"));
+    // the mode belongs to the active display, the check mark only follows it as it may belong to another display
+    connect(toggleShadedAct, &QAction::triggered, this, [=]() {
+        if (activeDocumentId == -1) {
+            toggleShadedAct->setChecked(false);
+            return;
+        }
+
+        Display* display = documents[activeDocumentId]->getDisplayGrid()->getActiveDisplay();
+        display->shadedModeEnabled = !display->shadedModeEnabled;
+        toggleShadedAct->setChecked(display->shadedModeEnabled);
+        display->forceRerenderFrame();
+    });
+    viewMenu->addAction(toggleShadedAct);
+
+    QAction* toggleStatisticsAct = new QAction(tr("Toggle frame statistics on/off"), this);
+    toggleStatisticsAct->setCheckable(true);
+    toggleStatisticsAct->setStatusTip(tr("Show frame times, draw calls and culling counters on the active viewport"));
+    // like the shaded mode, the overlay belongs to the active display
+    connect(toggleStatisticsAct, &QAction::triggered, this, [=]() {
+        if (activeDocumentId == -1) {
+            toggleStatisticsAct->setChecked(false);
+            return;
+        }
+
+        Display* display = documents[activeDocumentId]->getDisplayGrid()->getActiveDisplay();
+        display->statisticsOverlayEnabled = !display->statisticsOverlayEnabled;
+        toggleStatisticsAct->setChecked(display->statisticsOverlayEnabled);
+        display->forceRerenderFrame();
+    });
+    viewMenu->addAction(toggleStatisticsAct);
+
+    QAction* recordStatisticsAct = new QAction(tr("Record frame statistics to CSV..."), this);
+    recordStatisticsAct->setCheckable(true);
+    recordStatisticsAct->setStatusTip(tr("Write the statistics of every frame of the active viewport to a CSV file"));
+    connect(recordStatisticsAct, &QAction::toggled, this, [=](bool checked) {
+        if (activeDocumentId == -1) {
+            if (checked) recordStatisticsAct->setChecked(false);
+            return;
+        }
+
+        FrameStatistics* frameStatistics = documents[activeDocumentId]->getDisplayGrid()->getActiveDisplay()->getFrameStatistics();
+        if (!checked) {
+            frameStatistics->stopCsv();
+            return;
+        }
+
+        const QString filePath = QFileDialog::getSaveFileName(this, tr("Save frame statistics"), QString(), "CSV (*.csv)");
+        if (filePath.isEmpty() || !frameStatistics->startCsv(filePath)) {
+            recordStatisticsAct->setChecked(false);
+            return;
+        }
+        statusBar->showMessage("Recording frame statistics to " + filePath, statusBarShortMessageDuration);
+    });
+    viewMenu->addAction(recordStatisticsAct);
+
 
     QMenu* selectThemeAct = viewMenu->addMenu(tr("Select theme"));
     QActionGroup *selectThemeActGroup = new QActionGroup(this);
@@ -544,13 +603,45 @@ void MainWindow::prepareUi() {
     raytraceAct->setShortcut(Qt::CTRL|Qt::Key_R);
     connect(raytraceAct, &QAction::triggered, this, [this](){
         if (activeDocumentId == -1) return;
+        // the raytrace view shows its progress and reports when it is done
         statusBar->showMessage("Raytracing current viewport...", statusBarShortMessageDuration);
-        QCoreApplication::processEvents();
         documents[activeDocumentId]->getRaytraceWidget()->raytrace();
-        statusBar->showMessage("Raytracing completed.", statusBarShortMessageDuration);
     });
     raytrace->addAction(raytraceAct);
 
+    QAction* raytraceToFileAct = new QAction(tr("Raytrace current viewport to file..."), this);
+    raytraceToFileAct->setStatusTip(tr("Raytrace current viewport at any size into a TIFF file, tile by tile"));
+    connect(raytraceToFileAct, &QAction::triggered, this, [this](){
+        if (activeDocumentId == -1) return;
+        QSettings settings("BRLCAD", "arbalest");
+        bool ok = false;
+        const QString size = QInputDialog::getText(this, tr("Raytrace to file"), tr("Image size (width x height):"),
+                                                   QLineEdit::Normal, settings.value("raytraceToFileSize", "8000x6000").toString(), &ok);
+        if (!ok) return;
+        const QStringList sizes = size.split(QRegExp("\\s*[xX]\\s*"));
+        const int w = sizes.size() == 2 ? sizes[0].trimmed().toInt() : 0;
+        const int h = sizes.size() == 2 ? sizes[1].trimmed().toInt() : 0;
+        if (w <= 0 || h <= 0) {
+            statusBar->showMessage("Invalid image size, expected for example 8000x6000.", statusBarShortMessageDuration);
+            return;
+        }
+        settings.setValue("raytraceToFileSize", size);
+
+        const QString filePath = QFileDialog::getSaveFileName(this, tr("Raytrace to file"), QString(), "TIFF file (*.tif *.tiff)");
+        if (filePath.isEmpty()) return;
+        documents[activeDocumentId]->getRaytraceWidget()->raytraceToFile(filePath, w, h);
+    });
+    raytrace->addAction(raytraceToFileAct);
+
+    QAction* raytraceOverlapsAct = new QAction(tr("Show overlaps in current viewport"), this);
+    raytraceOverlapsAct->setStatusTip(tr("Quick overlap check: raytrace current viewport as an overlap heat map and list the overlapping regions"));
+    connect(raytraceOverlapsAct, &QAction::triggered, this, [this](){
+        if (activeDocumentId == -1) return;
+        statusBar->showMessage("Raytracing overlaps in current viewport...", statusBarShortMessageDuration);
+        documents[activeDocumentId]->getRaytraceWidget()->raytraceOverlaps();
+    });
+    raytrace->addAction(raytraceOverlapsAct);
+
     QAction* setRaytraceBackgroundColorAct = new QAction(tr("Set raytrace background color.."), this);
     connect(setRaytraceBackgroundColorAct, &QAction::triggered, this, [this](){
         QSettings settings("BRLCAD", "arbalest");
@@ -560,6 +651,16 @@ void MainWindow::prepareUi() {
     });
     raytrace->addAction(setRaytraceBackgroundColorAct);
 
+    QAction* raytraceAntiAliasingAct = new QAction(tr("Anti-aliasing (supersample edges)"), this);
+    raytraceAntiAliasingAct->setStatusTip(tr("Shoot extra rays at the edges of regions and surfaces"));
+    raytraceAntiAliasingAct->setCheckable(true);
+    raytraceAntiAliasingAct->setChecked(settings.value("raytraceAntiAliasing", false).toBool());
+    connect(raytraceAntiAliasingAct, &QAction::toggled, this, [](bool checked){
+        QSettings settings("BRLCAD", "arbalest");
+        settings.setValue("raytraceAntiAliasing", checked);
+    });
+    raytrace->addAction(raytraceAntiAliasingAct);
+
     QMenu* verifyValidateMenu = menuTitleBar->addMenu(tr("&Verify/Validate"));
     verifyValidateViewportAct = new QAction(tr("Verify and validate current viewport"), this);
     verifyValidateViewportAct->setStatusTip(tr("Verify and validate current viewport"));
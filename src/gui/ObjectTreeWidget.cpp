@@ -44,7 +44,14 @@ ObjectTreeWidget::ObjectTreeWidget(Document* document, QWidget* parent) : docume
 	setColumnCount(1);
 	setMouseTracking(true);
 
-	build(0);
+	buildItems(0, nullptr);
+
+    filterBox = new QLineEdit(this);
+    filterBox->setObjectName("objectTreeFilterBox");
+    filterBox->setPlaceholderText("Filter objects (name or /path)");
+    filterBox->setClearButtonEnabled(true);
+    setViewportMargins(0, filterBox->sizeHint().height(), 0, 0);
+    connect(filterBox, &QLineEdit::textChanged, this, &ObjectTreeWidget::setFilter);
 
     ObjectTreeRowButtons *visibilityButton = new ObjectTreeRowButtons(document->getObjectTree(), this);
     setItemDelegateForColumn(0, visibilityButton);
@@ -78,6 +85,13 @@ ObjectTreeWidget::ObjectTreeWidget(Document* document, QWidget* parent) : docume
 }
 
 void ObjectTreeWidget::build(const int objectId, QTreeWidgetItem* parent)
+{
+    buildItems(objectId, parent);
+    // the new items are hidden if they don't match
+    if (!filterBox->text().isEmpty()) setFilter(filterBox->text());
+}
+
+void ObjectTreeWidget::buildItems(const int objectId, QTreeWidgetItem* parent)
 {
 	QTreeWidgetItem* item = nullptr;
 
@@ -87,6 +101,12 @@ void ObjectTreeWidget::build(const int objectId, QTreeWidgetItem* parent)
         item->setText(0,document->getObjectTree()->getNameMap()[objectId]);
         item->setData(0, Qt::UserRole, objectId);
 
+        // new objects get larger ids than all others, so they can be added to built indices
+        if (nameIndex.size() != 0) {
+            nameIndex.add(objectId, document->getObjectTree()->getNameMap()[objectId]);
+            fullPathIndex.add(objectId, document->getObjectTree()->getFullPathMap()[objectId]);
+        }
+
         if (parent != nullptr) {
             parent->addChild(item);
         } else {
@@ -96,16 +116,88 @@ void ObjectTreeWidget::build(const int objectId, QTreeWidgetItem* parent)
 
 	for (int childObjectId : document->getObjectTree()->getChildren()[objectId])
 	{
-		build(childObjectId, objectId ? item: nullptr);
+		buildItems(childObjectId, objectId ? item: nullptr);
 	}
 }
 
+void ObjectTreeWidget::selectObject(const int objectId)
+{
+    QTreeWidgetItem* item = objectIdTreeWidgetItemMap.value(objectId, nullptr);
+    if (item == nullptr) return;
+    setCurrentItem(item);
+    scrollToItem(item);
+}
+
+void ObjectTreeWidget::resizeEvent(QResizeEvent* event) {
+    QTreeWidget::resizeEvent(event);
+    const QRect viewportRect = viewport()->geometry();
+    filterBox->setGeometry(viewportRect.left(), viewportRect.top() - filterBox->sizeHint().height(),
+                           viewportRect.width(), filterBox->sizeHint().height());
+}
+
+void ObjectTreeWidget::buildFilterIndices() {
+    nameIndex.clear();
+    fullPathIndex.clear();
+    ObjectTree* objectTree = document->getObjectTree();
+    objectTree->traverse(0, false, [this, objectTree](int objectId){
+        if (!objectIdTreeWidgetItemMap.contains(objectId)) return true;
+        nameIndex.add(objectId, objectTree->getNameMap()[objectId]);
+        fullPathIndex.add(objectId, objectTree->getFullPathMap()[objectId]);
+        return true;
+    });
+}
+
+void ObjectTreeWidget::setFilter(const QString& filter) {
+    ObjectTree* objectTree = document->getObjectTree();
+    QSet<int> hiddenObjectIds;
+
+    if (!filter.isEmpty()) {
+        if (nameIndex.size() == 0) buildFilterIndices();
+        const QVector<int> matches = filter.contains('/') ? fullPathIndex.search(filter) : nameIndex.search(filter);
+
+        // Matches and their ancestors stay visible, everything below a match stays visible too.
+        // Only the children of unmatched ancestors (and top level objects) need to be hidden, hidden items hide their
+        // whole sub tree anyway. So the cost depends on the matches rather than the size of the tree.
+        QSet<int> matchedObjectIds;
+        QSet<int> ancestorObjectIds;
+        ancestorObjectIds.insert(0);
+        for (int objectId : matches) {
+            matchedObjectIds.insert(objectId);
+            int ancestorId = objectTree->getParent()[objectId];
+            while (ancestorId > 0 && !ancestorObjectIds.contains(ancestorId)) {
+                ancestorObjectIds.insert(ancestorId);
+                ancestorId = objectTree->getParent()[ancestorId];
+            }
+        }
+
+        for (int ancestorId : ancestorObjectIds) {
+            if (matchedObjectIds.contains(ancestorId)) continue;
+            for (int childId : objectTree->getChildren()[ancestorId]) {
+                if (!matchedObjectIds.contains(childId) && !ancestorObjectIds.contains(childId)) hiddenObjectIds.insert(childId);
+            }
+        }
+
+        for (int ancestorId : ancestorObjectIds) {
+            if (ancestorId != 0 && objectIdTreeWidgetItemMap.contains(ancestorId)) objectIdTreeWidgetItemMap[ancestorId]->setExpanded(true);
+        }
+    }
+
+    // only touch the items whose state changes
+    for (int objectId : filterHiddenObjectIds) {
+        if (!hiddenObjectIds.contains(objectId) && objectIdTreeWidgetItemMap.contains(objectId)) objectIdTreeWidgetItemMap[objectId]->setHidden(false);
+    }
+    for (int objectId : hiddenObjectIds) {
+        if (!filterHiddenObjectIds.contains(objectId) && objectIdTreeWidgetItemMap.contains(objectId)) objectIdTreeWidgetItemMap[objectId]->setHidden(true);
+    }
+    filterHiddenObjectIds = hiddenObjectIds;
+}
+
 const QHash<int, QTreeWidgetItem *> &ObjectTreeWidget::getObjectIdTreeWidgetItemMap() const {
     return objectIdTreeWidgetItemMap;
 }
 
 void ObjectTreeWidget::refreshItemTextColors() {
-    document->getObjectTree()->traverseSubTree(0,false,[this](int objectId){
+    document->getObjectTree()->traverse(0,false,[this](int objectId){
         switch (document->getObjectTree()->getObjectVisibility()[objectId]){
 
             case ObjectTree::Invisible:
@@ -142,7 +234,7 @@ QStringList ObjectTreeWidget::getSelectedObjects(const Name& name, const Level&
     
     // otherwise check entire tree
     else {
-        document->getObjectTree()->traverseSubTree(0,false,[this, &ans, objTree]
+        document->getObjectTree()->traverse(0,false,[this, &ans, objTree]
         (int objectId){
             if (objTree->getObjectVisibility()[objectId] != ObjectTree::VisibilityState::FullyVisible) return true;
 
@@ -29,8 +29,8 @@ void Properties::bindObject(const int objectId) {
     fullPathWidget->setText(QString(fullPath).replace("/"," / "));
 
     delete object;
-    object = document.getDatabase()->Get(fullPath.toUtf8().data());
-    objectType = QString(object->Type());
+    object = document.getObjectCopy(fullPath);
+    objectType = document.getObjectTree()->getObjectType(objectId);
 
     delete current;
     current = new TypeSpecificProperties(document, object, objectId);
@@ -36,8 +36,10 @@ TypeSpecificProperties::TypeSpecificProperties(Document &document, BRLCAD::Objec
 
     const QStringList pointsIndices = {"P1", "P2", "P3", "P4", "P5", "P6", "P7", "P8"};
     const QStringList abcdIndices = {"A", "B", "C", "D", "E", "F"};
+    // the type was recorded when the object tree was built
+    const QString& type = document.getObjectTree()->getObjectType(objectId);
 
-    if(QString(object->Type()) == "Combination") {
+    if(type == "Combination") {
         BRLCAD::Combination *comb = dynamic_cast<BRLCAD::Combination*>(object);
 
         CollapsibleWidget *childrenListCollapsible = new CollapsibleWidget();
@@ -92,7 +94,7 @@ TypeSpecificProperties::TypeSpecificProperties(Document &document, BRLCAD::Objec
         });*/
     }
 
-    if(QString(object->Type()) == "Arb8") {
+    if(type == "Arb8") {
         ObjectDataField<BRLCAD::Arb8> * property;
         property = new ObjectDataField<BRLCAD::Arb8>(
                 &document,
@@ -107,7 +109,7 @@ TypeSpecificProperties::TypeSpecificProperties(Document &document, BRLCAD::Objec
     }
 
 
-    if(QString(object->Type()) == "Cone") {
+    if(type == "Cone") {
         ObjectDataField<BRLCAD::Cone> * property;
 
         property = new ObjectDataField<BRLCAD::Cone>(
@@ -139,7 +141,7 @@ TypeSpecificProperties::TypeSpecificProperties(Document &document, BRLCAD::Objec
     }
 
 
-    if(QString(object->Type()) == "Ellipsoid") {
+    if(type == "Ellipsoid") {
         ObjectDataField<BRLCAD::Ellipsoid> * property;
 
         property = new ObjectDataField<BRLCAD::Ellipsoid>(
@@ -163,7 +165,7 @@ TypeSpecificProperties::TypeSpecificProperties(Document &document, BRLCAD::Objec
     }
 
 
-    if(QString(object->Type()) == "EllipticalTorus") {
+    if(type == "EllipticalTorus") {
         ObjectDataField<BRLCAD::EllipticalTorus> * property;
 
         property = new ObjectDataField<BRLCAD::EllipticalTorus>(
@@ -209,7 +211,7 @@ TypeSpecificProperties::TypeSpecificProperties(Document &document, BRLCAD::Objec
     }
 
 
-    if(QString(object->Type()) == "Halfspace") {
+    if(type == "Halfspace") {
         ObjectDataField<BRLCAD::Halfspace> * property;
 
         property = new ObjectDataField<BRLCAD::Halfspace>(
@@ -231,7 +233,7 @@ TypeSpecificProperties::TypeSpecificProperties(Document &document, BRLCAD::Objec
     }
 
 
-    if(QString(object->Type()) == "HyperbolicCylinder") {
+    if(type == "HyperbolicCylinder") {
         ObjectDataField<BRLCAD::HyperbolicCylinder> * property;
 
         property = new ObjectDataField<BRLCAD::HyperbolicCylinder>(
@@ -276,7 +278,7 @@ TypeSpecificProperties::TypeSpecificProperties(Document &document, BRLCAD::Objec
     }
 
 
-    if(QString(object->Type()) == "Hyperboloid") {
+    if(type == "Hyperboloid") {
         ObjectDataField<BRLCAD::Hyperboloid> * property;
 
         property = new ObjectDataField<BRLCAD::Hyperboloid>(
@@ -337,7 +339,7 @@ TypeSpecificProperties::TypeSpecificProperties(Document &document, BRLCAD::Objec
     }
 
 
-    if(QString(object->Type()) == "ParabolicCylinder") {
+    if(type == "ParabolicCylinder") {
         ObjectDataField<BRLCAD::ParabolicCylinder> * property;
 
         property = new ObjectDataField<BRLCAD::ParabolicCylinder>(
@@ -374,7 +376,7 @@ TypeSpecificProperties::TypeSpecificProperties(Document &document, BRLCAD::Objec
     }
 
 
-    if(QString(object->Type()) == "Paraboloid") {
+    if(type == "Paraboloid") {
         ObjectDataField<BRLCAD::Paraboloid> * property;
 
         property = new ObjectDataField<BRLCAD::Paraboloid>(
@@ -427,7 +429,7 @@ TypeSpecificProperties::TypeSpecificProperties(Document &document, BRLCAD::Objec
     }
 
 
-    if(QString(object->Type()) == "Particle") {
+    if(type == "Particle") {
         ObjectDataField<BRLCAD::Particle> * property;
 
         property = new ObjectDataField<BRLCAD::Particle>(
@@ -464,7 +466,7 @@ TypeSpecificProperties::TypeSpecificProperties(Document &document, BRLCAD::Objec
     }
 
 
-    if(QString(object->Type()) == "Sphere") {
+    if(type == "Sphere") {
         ObjectDataField<BRLCAD::Sphere> * property;
 
         property = new ObjectDataField<BRLCAD::Sphere>(
@@ -485,7 +487,7 @@ TypeSpecificProperties::TypeSpecificProperties(Document &document, BRLCAD::Objec
     }
 
 
-    if(QString(object->Type()) == "Torus") {
+    if(type == "Torus") {
         ObjectDataField<BRLCAD::Torus> * property;
 
         property = new ObjectDataField<BRLCAD::Torus>(
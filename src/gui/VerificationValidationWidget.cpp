@@ -19,12 +19,10 @@ msgBoxRes(NO_SELECTION), dbConnectionName(""), runningTests(false), btnCollapseT
     if (!dbConnectionName.isEmpty()) return;
 
     // get BRL-CAD cache path
-    char cache[MAXPATHLEN];
-    bu_dir(cache, MAXPATHLEN, BU_DIR_CACHE, ".atr", NULL);
-    cacheFolder = QString(cache);
+    cacheFolder = getCacheFolder();
     
     // create cache if doesn't already exist
-    QDir dirCacheFolder(cache);
+    QDir dirCacheFolder(cacheFolder);
     if (!dirCacheFolder.exists() && !dirCacheFolder.mkpath(".")) throw std::runtime_error("Failed to create atr cache folder");
    
     QString dbFilePath = cacheFolder + "/untitled/" + QString::number(document->getDocumentId()) + ".atr";;
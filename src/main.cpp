@@ -2,6 +2,7 @@
 
 #include <QApplication>
 #include <DisplayGrid.h>
+#include "CommandLine.h"
 #include "MainWindow.h"
 
 int main(int argc, char*argv[]) {
@@ -14,7 +15,14 @@ int main(int argc, char*argv[]) {
 #endif
 
 
+    // All displays (and offscreen contexts) share their buffers, so geometry of a document is uploaded once
+    // and survives displays being reparented when switching between single and quad view
+    QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+    const bool commandLineRun = CommandLine::isRequested(argc, argv);
+    if (commandLineRun) CommandLine::setApplicationAttributes(argc, argv);
     QApplication app(argc,argv);
+    if (commandLineRun) return CommandLine().run();
+
     MainWindow mainWindow;
     mainWindow.showMaximized();
     return app.exec();
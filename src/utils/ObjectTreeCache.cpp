@@ -0,0 +1,273 @@
+/*                O B J E C T T R E E C A C H E . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file ObjectTreeCache.cpp */
+
+#include <cstring>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include "ObjectTreeCache.h"
+#include "ObjectTree.h"
+
+/*
+ * File layout:
+ *   CacheHeader
+ *   CachedObject[objectCount]      indexed by object id
+ *   qint32[childrenCount]          children lists of all objects, CachedObject refers to a range of these
+ *   CachedString[typeCount]        object type names
+ *   char[stringsSize]              UTF-8 names and type names, CachedObject and CachedString refer to these
+ */
+
+namespace {
+    const char cacheMagic[8] = {'A', 'R', 'B', 'T', 'R', 'E', 'E', '\0'};
+    const quint32 cacheVersion = 1;
+    const quint32 cacheByteOrderMark = 0x01020304;
+
+    struct CacheHeader {
+        char magic[8];
+        quint32 version;
+        quint32 byteOrderMark;
+        char uuid[40];
+        qint32 lastAllocatedId;
+        quint32 objectCount;
+        quint32 childrenCount;
+        quint32 typeCount;
+        quint64 stringsSize;
+    };
+
+    struct CachedString {
+        quint32 offset;
+        quint32 length;
+    };
+
+    enum CachedObjectFlags : quint8 {
+        HasName = 1,
+        HasParent = 2,
+        HasColor = 4,
+        IsRegion = 8,
+        Drawable = 16,
+    };
+
+    struct CachedObject {
+        qint32 parent;
+        qint32 regionId;
+        float color[3];
+        quint32 childrenOffset;
+        quint32 childrenCount;
+        CachedString name;
+        quint16 typeIndex;
+        quint8 flags;
+        quint8 padding;
+    };
+
+    void appendString(QByteArray& strings, CachedString& cachedString, const QString& string)
+    {
+        const QByteArray utf8 = string.toUtf8();
+        cachedString.offset = strings.size();
+        cachedString.length = utf8.size();
+        strings.append(utf8);
+    }
+}
+
+
+ObjectTreeCache::ObjectTreeCache(const QString& gFilePath)
+{
+    QString* fileUuid = generateUUID(gFilePath);
+    if (fileUuid == nullptr) return;
+    uuid = *fileUuid;
+    delete fileUuid;
+
+    const QString folderPath = getCacheFolder() + "/" + uuid.left(2) + "/" + uuid.right(uuid.size() - 2);
+    cacheFilePath = folderPath + "/" + QFileInfo(gFilePath).fileName() + ".tree";
+}
+
+bool ObjectTreeCache::load(ObjectTree* objectTree) const
+{
+    if (!isValid()) return false;
+
+    QFile file(cacheFilePath);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    const qint64 fileSize = file.size();
+    if (fileSize < static_cast<qint64>(sizeof(CacheHeader))) return false;
+    const uchar* data = file.map(0, fileSize);
+    if (data == nullptr) return false;
+
+    // validate everything before touching objectTree
+    const CacheHeader* header = reinterpret_cast<const CacheHeader*>(data);
+    const QByteArray uuidBytes = uuid.toLatin1();
+    if (memcmp(header->magic, cacheMagic, sizeof(cacheMagic)) != 0 || header->version != cacheVersion ||
+        header->byteOrderMark != cacheByteOrderMark ||
+        strncmp(header->uuid, uuidBytes.constData(), sizeof(header->uuid)) != 0 ||
+        header->objectCount == 0 || header->typeCount == 0 || header->lastAllocatedId < 0 ||
+        static_cast<quint32>(header->lastAllocatedId) >= header->objectCount) {
+        return false;
+    }
+
+    const quint64 objectsOffset = sizeof(CacheHeader);
+    const quint64 childrenOffset = objectsOffset + quint64(header->objectCount) * sizeof(CachedObject);
+    const quint64 typesOffset = childrenOffset + quint64(header->childrenCount) * sizeof(qint32);
+    const quint64 stringsOffset = typesOffset + quint64(header->typeCount) * sizeof(CachedString);
+    if (stringsOffset + header->stringsSize != static_cast<quint64>(fileSize)) return false;
+
+    const CachedObject* objects = reinterpret_cast<const CachedObject*>(data + objectsOffset);
+    const qint32* children = reinterpret_cast<const qint32*>(data + childrenOffset);
+    const CachedString* types = reinterpret_cast<const CachedString*>(data + typesOffset);
+    const char* strings = reinterpret_cast<const char*>(data + stringsOffset);
+
+    for (quint32 i = 0; i < header->typeCount; i++) {
+        if (quint64(types[i].offset) + types[i].length > header->stringsSize) return false;
+    }
+    for (quint32 objectId = 0; objectId < header->objectCount; objectId++) {
+        const CachedObject& object = objects[objectId];
+        if (quint64(object.childrenOffset) + object.childrenCount > header->childrenCount) return false;
+        if (quint64(object.name.offset) + object.name.length > header->stringsSize) return false;
+        if (object.typeIndex >= header->typeCount) return false;
+        if ((object.flags & HasParent) && (object.parent >= static_cast<qint32>(objectId) || object.parent < -1)) return false;
+        // children have larger ids than their parents (see save), so a corrupt file can not make traverse loop
+        for (quint32 i = 0; i < object.childrenCount; i++) {
+            const qint32 childId = children[object.childrenOffset + i];
+            if (childId <= static_cast<qint32>(objectId) || static_cast<quint32>(childId) >= header->objectCount) {
+                return false;
+            }
+        }
+    }
+
+    objectTree->lastAllocatedId = header->lastAllocatedId;
+    objectTree->reserveObjectId(header->objectCount - 1);
+    objectTree->objectTypes.clear();
+    objectTree->objectTypeIndices.clear();
+    for (quint32 i = 0; i < header->typeCount; i++) {
+        objectTree->objectTypeIndex(QByteArray(strings + types[i].offset, types[i].length).constData());
+    }
+
+    objectTree->fullPathMap[0] = "";
+    for (quint32 objectId = 0; objectId < header->objectCount; objectId++) {
+        const CachedObject& object = objects[objectId];
+
+        QVector<int>& objectChildren = objectTree->objectIdChildrenObjectIdsMap[objectId];
+        objectChildren.resize(object.childrenCount);
+        for (quint32 i = 0; i < object.childrenCount; i++) objectChildren[i] = children[object.childrenOffset + i];
+
+        if (object.flags & HasName) {
+            objectTree->nameMap[objectId] = QString::fromUtf8(strings + object.name.offset, object.name.length);
+        }
+
+        // parents always have smaller ids than their children, so the parent's full path is already known here
+        if (object.flags & HasParent) {
+            objectTree->objectIdParentObjectIdMap[objectId] = object.parent;
+            if (objectId != 0) {
+                objectTree->fullPathMap[objectId] = objectTree->fullPathMap[object.parent] + "/" + objectTree->nameMap[objectId];
+            }
+        }
+
+        ColorInfo& color = objectTree->colorMap[objectId];
+        color.red = object.color[0];
+        color.green = object.color[1];
+        color.blue = object.color[2];
+        color.hasColor = object.flags & HasColor;
+
+        ObjectTree::ObjectInfo& info = objectTree->objectInfo[objectId];
+        info.typeIndex = object.typeIndex;
+        info.isRegion = object.flags & IsRegion;
+        info.regionId = object.regionId;
+
+        if (object.flags & Drawable) objectTree->drawableObjectIds.insert(objectId);
+    }
+
+    file.unmap(const_cast<uchar*>(data));
+    return true;
+}
+
+bool ObjectTreeCache::save(const ObjectTree* objectTree) const
+{
+    if (!isValid()) return false;
+
+    QDir cacheFolder = QFileInfo(cacheFilePath).dir();
+    if (!cacheFolder.exists() && !cacheFolder.mkpath(".")) return false;
+
+    const quint32 objectCount = objectTree->colorMap.size();
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.byteOrderMark = cacheByteOrderMark;
+    const QByteArray uuidBytes = uuid.toLatin1();
+    strncpy(header.uuid, uuidBytes.constData(), sizeof(header.uuid) - 1);
+    header.lastAllocatedId = objectTree->lastAllocatedId;
+    header.objectCount = objectCount;
+    header.typeCount = objectTree->objectTypes.size();
+
+    QVector<CachedObject> objects(objectCount);
+    QVector<qint32> children;
+    QVector<CachedString> types(header.typeCount);
+    QByteArray strings;
+
+    for (quint32 objectId = 0; objectId < objectCount; objectId++) {
+        CachedObject& object = objects[objectId];
+        memset(&object, 0, sizeof(object));
+
+        const QVector<int>& objectChildren = objectTree->objectIdChildrenObjectIdsMap[objectId];
+        object.childrenOffset = children.size();
+        object.childrenCount = objectChildren.size();
+        for (int childId : objectChildren) children.append(childId);
+
+        QHash<int, QString>::const_iterator name = objectTree->nameMap.constFind(objectId);
+        if (name != objectTree->nameMap.constEnd()) {
+            appendString(strings, object.name, name.value());
+            object.flags |= HasName;
+        }
+
+        QHash<int, int>::const_iterator parent = objectTree->objectIdParentObjectIdMap.constFind(objectId);
+        if (parent != objectTree->objectIdParentObjectIdMap.constEnd()) {
+            object.parent = parent.value();
+            object.flags |= HasParent;
+        }
+
+        const ColorInfo& color = objectTree->colorMap[objectId];
+        object.color[0] = color.red;
+        object.color[1] = color.green;
+        object.color[2] = color.blue;
+        if (color.hasColor) object.flags |= HasColor;
+
+        const ObjectTree::ObjectInfo& info = objectTree->objectInfo[objectId];
+        object.typeIndex = info.typeIndex;
+        object.regionId = info.regionId;
+        if (info.isRegion) object.flags |= IsRegion;
+
+        if (objectTree->drawableObjectIds.contains(objectId)) object.flags |= Drawable;
+    }
+
+    for (quint32 i = 0; i < header.typeCount; i++) appendString(strings, types[i], objectTree->objectTypes[i]);
+
+    header.childrenCount = children.size();
+    header.stringsSize = strings.size();
+
+    QSaveFile file(cacheFilePath);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(objects.constData()), objects.size() * sizeof(CachedObject));
+    file.write(reinterpret_cast<const char*>(children.constData()), children.size() * sizeof(qint32));
+    file.write(reinterpret_cast<const char*>(types.constData()), types.size() * sizeof(CachedString));
+    file.write(strings);
+    return file.commit();
+}
@@ -0,0 +1,417 @@
+/*                      P L O T C A C H E . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file PlotCache.cpp */
+
+#include <cstring>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <raytrace.h>
+#include "PlotCache.h"
+#include "Utils.h"
+
+/*
+ * File layout:
+ *   CacheHeader
+ *   CachedPlot[entryCount]
+ *   data[dataSize]                 for each entry: GLfloat[vertexCount * 3], GLuint[indexCount], CachedRange[rangeCount],
+ *                                  GLfloat[surfaceVertexCount * 6], GLuint[surfaceIndexCount]
+ */
+
+namespace {
+    const char cacheMagic[8] = {'A', 'R', 'B', 'P', 'L', 'O', 'T', '\0'};
+    const quint32 cacheVersion = 3;
+    const quint32 cacheByteOrderMark = 0x01020304;
+    const int keySize = 16;
+
+    struct CacheHeader {
+        char magic[8];
+        quint32 version;
+        quint32 byteOrderMark;
+        quint32 saveCount;
+        quint32 entryCount;
+        quint64 dataSize;
+    };
+
+    struct CachedPlot {
+        char key[keySize];
+        quint32 vertexCount;
+        quint32 indexCount;
+        quint32 rangeCount;
+        quint32 surfaceVertexCount;
+        quint32 surfaceIndexCount;
+        quint32 lastUsedSave;
+        quint64 dataOffset;
+    };
+
+    struct CachedRange {
+        quint32 mode;
+        float size;
+        quint32 firstIndex;
+        quint32 indexCount;
+    };
+
+    quint64 entryDataSize(quint32 vertexCount, quint32 indexCount, quint32 rangeCount, quint32 surfaceVertexCount,
+                          quint32 surfaceIndexCount)
+    {
+        return quint64(vertexCount) * 3 * sizeof(GLfloat) + quint64(indexCount) * sizeof(GLuint) +
+               quint64(rangeCount) * sizeof(CachedRange) + quint64(surfaceVertexCount) * 6 * sizeof(GLfloat) +
+               quint64(surfaceIndexCount) * sizeof(GLuint);
+    }
+
+    bool indicesBelow(const QVector<GLuint>& indices, const quint32 count)
+    {
+        for (GLuint index : indices) {
+            if (index >= count) return false;
+        }
+        return true;
+    }
+}
+
+
+PlotCache::PlotCache(const QString& gFilePath) : gFilePath(gFilePath)
+{
+    const QString absolutePath = QFileInfo(gFilePath).absoluteFilePath();
+    const QString pathHash = QCryptographicHash::hash(absolutePath.toUtf8(), QCryptographicHash::Md5).toHex();
+    const QString folderPath = getCacheFolder() + "/" + pathHash.left(2) + "/" + pathHash.right(pathHash.size() - 2);
+    cacheFilePath = folderPath + "/" + QFileInfo(gFilePath).fileName() + ".plot";
+    openRecordDatabase();
+}
+
+PlotCache::~PlotCache()
+{
+    unmap();
+    closeRecordDatabase();
+}
+
+void PlotCache::unmap()
+{
+    if (mappedData != nullptr) mappedFile.unmap(mappedData);
+    mappedData = nullptr;
+    mappedFile.close();
+    QMutexLocker locker(&mutex);
+    mappedEntries.clear();
+}
+
+// librt's directory allocations are not thread safe, so this does not run while objects are plotted
+void PlotCache::openRecordDatabase()
+{
+    QMutexLocker locker(&recordMutex);
+    recordDatabase = db_open(gFilePath.toUtf8().constData(), DB_OPEN_READONLY);
+    if (recordDatabase != nullptr && db_dirbuild(recordDatabase) < 0) {
+        db_close(recordDatabase);
+        recordDatabase = nullptr;
+    }
+}
+
+void PlotCache::closeRecordDatabase()
+{
+    QMutexLocker locker(&recordMutex);
+    if (recordDatabase != nullptr) db_close(recordDatabase);
+    recordDatabase = nullptr;
+}
+
+bool PlotCache::load()
+{
+    if (!isValid()) return false;
+    unmap();
+
+    mappedFile.setFileName(cacheFilePath);
+    if (!mappedFile.open(QIODevice::ReadOnly)) return false;
+
+    const qint64 fileSize = mappedFile.size();
+    if (fileSize < static_cast<qint64>(sizeof(CacheHeader))) {
+        mappedFile.close();
+        return false;
+    }
+    uchar* data = mappedFile.map(0, fileSize);
+    if (data == nullptr) {
+        mappedFile.close();
+        return false;
+    }
+
+    // the sizes are checked here, the contents of an entry when find() uses it
+    const CacheHeader* header = reinterpret_cast<const CacheHeader*>(data);
+    const quint64 entriesOffset = sizeof(CacheHeader);
+    const quint64 dataOffset = entriesOffset + quint64(header->entryCount) * sizeof(CachedPlot);
+    if (memcmp(header->magic, cacheMagic, sizeof(cacheMagic)) != 0 || header->version != cacheVersion ||
+        header->byteOrderMark != cacheByteOrderMark || dataOffset > static_cast<quint64>(fileSize) ||
+        dataOffset + header->dataSize != static_cast<quint64>(fileSize)) {
+        mappedFile.unmap(data);
+        mappedFile.close();
+        return false;
+    }
+
+    const CachedPlot* entries = reinterpret_cast<const CachedPlot*>(data + entriesOffset);
+    QHash<QByteArray, MappedEntry> loadedEntries;
+    loadedEntries.reserve(header->entryCount);
+    for (quint32 i = 0; i < header->entryCount; i++) {
+        const CachedPlot& entry = entries[i];
+        if (entry.dataOffset % sizeof(GLfloat) != 0 || entry.dataOffset > header->dataSize ||
+            entryDataSize(entry.vertexCount, entry.indexCount, entry.rangeCount, entry.surfaceVertexCount,
+                          entry.surfaceIndexCount) > header->dataSize - entry.dataOffset) {
+            mappedFile.unmap(data);
+            mappedFile.close();
+            return false;
+        }
+        loadedEntries[QByteArray(entry.key, keySize)] = {entry.vertexCount, entry.indexCount, entry.rangeCount,
+                                                         entry.surfaceVertexCount, entry.surfaceIndexCount,
+                                                         entry.lastUsedSave, data + dataOffset + entry.dataOffset};
+    }
+
+    mappedData = data;
+    saveCount = header->saveCount;
+    QMutexLocker locker(&mutex);
+    mappedEntries = loadedEntries;
+    return true;
+}
+
+/*
+ * The record is the object as librt stores it in the .g file, read through a database of its own, so hashing does not
+ * need the document's database (and its mutex). Records are only read while the object has not been changed in memory.
+ * Looking up and reading a record allocates nothing from librt's shared free lists.
+ */
+QByteArray PlotCache::recordHash(const QString& objectName)
+{
+    QMutexLocker locker(&recordMutex);
+    if (modifiedObjectNames.contains(objectName)) return QByteArray();
+    QHash<QString, QByteArray>::const_iterator it = recordHashes.constFind(objectName);
+    if (it != recordHashes.constEnd()) return it.value();
+
+    QByteArray hash;
+    const directory* dp = recordDatabase != nullptr ?
+                          db_lookup(recordDatabase, objectName.toUtf8().constData(), LOOKUP_QUIET) : nullptr;
+    if (dp != nullptr) {
+        bu_external record;
+        BU_EXTERNAL_INIT(&record);
+        if (db_get_external(&record, dp, recordDatabase) >= 0) {
+            hash = QCryptographicHash::hash(QByteArray::fromRawData(reinterpret_cast<const char*>(record.ext_buf),
+                                                                    static_cast<int>(record.ext_nbytes)),
+                                            QCryptographicHash::Md5);
+            bu_free_external(&record);
+        }
+    }
+    recordHashes[objectName] = hash;
+    return hash;
+}
+
+QByteArray PlotCache::objectKey(const QString& objectName, const QByteArray& pathMatrices)
+{
+    const QByteArray hash = recordHash(objectName);
+    if (hash.isEmpty()) return QByteArray();
+
+    QCryptographicHash key(QCryptographicHash::Md5);
+    key.addData(hash);
+    key.addData(pathMatrices);
+    return key.result().left(keySize);
+}
+
+bool PlotCache::find(const QByteArray& key, PlotGeometry& geometry)
+{
+    QMutexLocker locker(&mutex);
+    QHash<QByteArray, PlotGeometry>::const_iterator inserted = insertedEntries.constFind(key);
+    if (inserted != insertedEntries.constEnd()) {
+        geometry = inserted.value();
+        return true;
+    }
+
+    QHash<QByteArray, MappedEntry>::const_iterator mapped = mappedEntries.constFind(key);
+    if (mapped == mappedEntries.constEnd()) return false;
+    const MappedEntry entry = mapped.value();
+    locker.unlock();
+
+    const GLfloat* vertices = reinterpret_cast<const GLfloat*>(entry.data);
+    const GLuint* indices = reinterpret_cast<const GLuint*>(vertices + entry.vertexCount * 3);
+    const CachedRange* ranges = reinterpret_cast<const CachedRange*>(indices + entry.indexCount);
+    const GLfloat* surfaceVertices = reinterpret_cast<const GLfloat*>(ranges + entry.rangeCount);
+    const GLuint* surfaceIndices = reinterpret_cast<const GLuint*>(surfaceVertices + entry.surfaceVertexCount * 6);
+
+    PlotGeometry copy;
+    copy.vertices.resize(entry.vertexCount * 3);
+    memcpy(copy.vertices.data(), vertices, entry.vertexCount * 3 * sizeof(GLfloat));
+    copy.indices.resize(entry.indexCount);
+    memcpy(copy.indices.data(), indices, entry.indexCount * sizeof(GLuint));
+    copy.ranges.resize(entry.rangeCount);
+    for (quint32 i = 0; i < entry.rangeCount; i++) {
+        copy.ranges[i].mode = ranges[i].mode;
+        copy.ranges[i].size = ranges[i].size;
+        copy.ranges[i].firstIndex = ranges[i].firstIndex;
+        copy.ranges[i].indexCount = ranges[i].indexCount;
+    }
+    copy.surfaceVertices.resize(entry.surfaceVertexCount * 6);
+    memcpy(copy.surfaceVertices.data(), surfaceVertices, entry.surfaceVertexCount * 6 * sizeof(GLfloat));
+    copy.surfaceIndices.resize(entry.surfaceIndexCount);
+    memcpy(copy.surfaceIndices.data(), surfaceIndices, entry.surfaceIndexCount * sizeof(GLuint));
+
+    // a corrupt entry would make GeometryBatch and generateLevels read outside of the arrays, it is plotted again
+    bool valid = indicesBelow(copy.indices, entry.vertexCount) &&
+                 indicesBelow(copy.surfaceIndices, entry.surfaceVertexCount) &&
+                 entry.surfaceIndexCount % 3 == 0;
+    for (const PlotGeometry::DrawRange& range : copy.ranges) {
+        valid = valid && (range.mode == GL_LINES || range.mode == GL_POINTS) && range.firstIndex >= 0 &&
+                range.indexCount >= 0 && quint64(range.firstIndex) + quint64(range.indexCount) <= entry.indexCount &&
+                (range.mode != GL_LINES || range.indexCount % 2 == 0);
+    }
+
+    locker.relock();
+    if (!valid) {
+        mappedEntries.remove(key);
+        dirty = true;
+        return false;
+    }
+    usedKeys.insert(key);
+    locker.unlock();
+
+    geometry = std::move(copy);
+    geometry.updateBounds();
+    return true;
+}
+
+void PlotCache::insert(const QByteArray& key, const QString& objectName, const PlotGeometry& geometry)
+{
+    {
+        QMutexLocker locker(&recordMutex);
+        if (modifiedObjectNames.contains(objectName)) return;
+    }
+
+    QMutexLocker locker(&mutex);
+    if (mappedEntries.contains(key)) return;
+
+    // only the plotted level is stored, coarser levels are cheap to generate again
+    PlotGeometry& entry = insertedEntries[key];
+    entry = geometry;
+    int levelIndexCount = 0;
+    for (const PlotGeometry::DrawRange& range : entry.ranges) {
+        levelIndexCount = qMax(levelIndexCount, range.firstIndex + range.indexCount);
+    }
+    entry.indices.resize(levelIndexCount);
+    entry.coarseLevels.clear();
+    dirty = true;
+}
+
+void PlotCache::objectModified(const QString& objectName)
+{
+    QMutexLocker locker(&recordMutex);
+    modifiedObjectNames.insert(objectName);
+    recordHashes.remove(objectName);
+}
+
+void PlotCache::fileSaved(const QString& gFilePath)
+{
+    closeRecordDatabase();
+    {
+        QMutexLocker locker(&recordMutex);
+        this->gFilePath = gFilePath;
+        recordHashes.clear();
+        modifiedObjectNames.clear();
+    }
+    openRecordDatabase();
+}
+
+bool PlotCache::save()
+{
+    if (!isValid()) return false;
+
+    QMutexLocker locker(&mutex);
+    if (!dirty && usedKeys.isEmpty()) return true;
+
+    QDir cacheFolder = QFileInfo(cacheFilePath).dir();
+    if (!cacheFolder.exists() && !cacheFolder.mkpath(".")) return false;
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.byteOrderMark = cacheByteOrderMark;
+    header.saveCount = saveCount + 1;
+
+    QVector<CachedPlot> entries;
+    auto addEntry = [&entries, &header](const QByteArray& key, quint32 vertexCount, quint32 indexCount,
+                                        quint32 rangeCount, quint32 surfaceVertexCount, quint32 surfaceIndexCount,
+                                        quint32 lastUsedSave) {
+        CachedPlot entry;
+        memset(&entry, 0, sizeof(entry));
+        memcpy(entry.key, key.constData(), keySize);
+        entry.vertexCount = vertexCount;
+        entry.indexCount = indexCount;
+        entry.rangeCount = rangeCount;
+        entry.surfaceVertexCount = surfaceVertexCount;
+        entry.surfaceIndexCount = surfaceIndexCount;
+        entry.lastUsedSave = lastUsedSave;
+        entry.dataOffset = header.dataSize;
+        header.dataSize += entryDataSize(vertexCount, indexCount, rangeCount, surfaceVertexCount, surfaceIndexCount);
+        entries.append(entry);
+    };
+
+    // entries of objects that changed are never found again, they are dropped after a while
+    QVector<const MappedEntry*> keptMappedEntries;
+    for (QHash<QByteArray, MappedEntry>::const_iterator it = mappedEntries.constBegin(); it != mappedEntries.constEnd(); ++it) {
+        const MappedEntry& entry = it.value();
+        const quint32 lastUsedSave = usedKeys.contains(it.key()) ? header.saveCount : entry.lastUsedSave;
+        if (header.saveCount - lastUsedSave > maxUnusedSaves) continue;
+        addEntry(it.key(), entry.vertexCount, entry.indexCount, entry.rangeCount, entry.surfaceVertexCount,
+                 entry.surfaceIndexCount, lastUsedSave);
+        keptMappedEntries.append(&it.value());
+    }
+    QVector<const PlotGeometry*> keptInsertedEntries;
+    for (QHash<QByteArray, PlotGeometry>::const_iterator it = insertedEntries.constBegin(); it != insertedEntries.constEnd(); ++it) {
+        const PlotGeometry& geometry = it.value();
+        addEntry(it.key(), geometry.vertexCount(), geometry.indices.size(), geometry.ranges.size(),
+                 geometry.surfaceVertexCount(), geometry.surfaceIndices.size(), header.saveCount);
+        keptInsertedEntries.append(&geometry);
+    }
+    header.entryCount = entries.size();
+
+    QSaveFile file(cacheFilePath);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.constData()), entries.size() * sizeof(CachedPlot));
+    for (const MappedEntry* entry : keptMappedEntries) {
+        file.write(reinterpret_cast<const char*>(entry->data),
+                   entryDataSize(entry->vertexCount, entry->indexCount, entry->rangeCount, entry->surfaceVertexCount,
+                                 entry->surfaceIndexCount));
+    }
+    for (const PlotGeometry* geometry : keptInsertedEntries) {
+        file.write(reinterpret_cast<const char*>(geometry->vertices.constData()), geometry->vertices.size() * sizeof(GLfloat));
+        file.write(reinterpret_cast<const char*>(geometry->indices.constData()), geometry->indices.size() * sizeof(GLuint));
+        for (const PlotGeometry::DrawRange& range : geometry->ranges) {
+            const CachedRange cachedRange = {range.mode, range.size, static_cast<quint32>(range.firstIndex),
+                                             static_cast<quint32>(range.indexCount)};
+            file.write(reinterpret_cast<const char*>(&cachedRange), sizeof(cachedRange));
+        }
+        file.write(reinterpret_cast<const char*>(geometry->surfaceVertices.constData()),
+                   geometry->surfaceVertices.size() * sizeof(GLfloat));
+        file.write(reinterpret_cast<const char*>(geometry->surfaceIndices.constData()),
+                   geometry->surfaceIndices.size() * sizeof(GLuint));
+    }
+
+    // the mapping has to be gone before the cache file is replaced
+    locker.unlock();
+    unmap();
+    if (!file.commit()) return false;
+
+    locker.relock();
+    insertedEntries.clear();
+    usedKeys.clear();
+    dirty = false;
+    locker.unlock();
+    return load();
+}
@@ -0,0 +1,315 @@
+/*                T I L E D T I F F W R I T E R . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file TiledTiffWriter.cpp */
+
+#include <algorithm>
+#include <cstring>
+#include <QDataStream>
+#include "TiledTiffWriter.h"
+
+
+/*
+ * File layout:
+ *   TIFF or BigTIFF header
+ *   image file directory with the tags below, sorted by tag
+ *   quint16[3]                     BitsPerSample, only if it does not fit into the directory entry (classic TIFF)
+ *   quint32 or quint64[tileCount]  TileOffsets
+ *   quint32 or quint64[tileCount]  TileByteCounts
+ *   tiles                          tileSize * tileSize * 3 bytes each, RGB, row by row
+ *
+ * Progress log: ProgressHeader, followed by the quint32 index of each written tile.
+ */
+
+namespace {
+    const char progressMagic[8] = {'A', 'R', 'B', 'T', 'I', 'L', 'E', '\0'};
+    const quint32 progressVersion = 1;
+
+    struct ProgressHeader {
+        char magic[8];
+        quint32 version;
+        quint32 w;
+        quint32 h;
+        quint32 tileSize;
+        quint64 signature;
+    };
+
+    enum TiffType : quint16 {
+        Short = 3,
+        Long = 4,
+        Long8 = 16
+    };
+
+    struct TiffEntry {
+        quint16 tag;
+        quint16 type;
+        quint64 count;
+        quint64 value;      // the value, or the offset of the values if they do not fit
+    };
+
+    const quint16 imageWidthTag = 256;
+    const quint16 imageLengthTag = 257;
+    const quint16 bitsPerSampleTag = 258;
+    const quint16 compressionTag = 259;
+    const quint16 photometricInterpretationTag = 262;
+    const quint16 samplesPerPixelTag = 277;
+    const quint16 planarConfigurationTag = 284;
+    const quint16 tileWidthTag = 322;
+    const quint16 tileLengthTag = 323;
+    const quint16 tileOffsetsTag = 324;
+    const quint16 tileByteCountsTag = 325;
+    const int entryCount = 11;
+}
+
+
+TiledTiffWriter::TiledTiffWriter(const QString& filePath, const int w, const int h, const int tileSize,
+                                 const quint64 signature) :
+    filePath(filePath), w(w), h(h), tileSize(tileSize), signature(signature), file(filePath),
+    progressFile(filePath + ".progress")
+{
+    tilesPerRow = (w + tileSize - 1) / tileSize;
+    tileCount = tilesPerRow * ((h + tileSize - 1) / tileSize);
+    writtenTiles.resize(tileCount);
+
+    // a classic TIFF addresses 4 GiB
+    const quint64 classicSize = 8 + 2 + entryCount * 12 + 4 + 6 + 2 * 4 * static_cast<quint64>(tileCount) +
+                                tileCount * tileByteCount();
+    bigTiff = classicSize > 0xffffffffull;
+}
+
+void TiledTiffWriter::forceBigTiff()
+{
+    bigTiff = true;
+}
+
+quint64 TiledTiffWriter::tileByteCount() const
+{
+    return static_cast<quint64>(tileSize) * tileSize * 3;
+}
+
+QByteArray TiledTiffWriter::header() const
+{
+    const quint64 offsetSize = bigTiff ? 8 : 4;
+    const quint64 directoryOffset = bigTiff ? 16 : 8;
+    const quint64 directorySize = bigTiff ? 8 + entryCount * 20 + 8 : 2 + entryCount * 12 + 4;
+    // three shorts fit into the 8 byte value of a BigTIFF entry
+    const quint64 bitsPerSampleOffset = directoryOffset + directorySize;
+    const quint64 tileOffsetsOffset = bitsPerSampleOffset + (bigTiff ? 0 : 6);
+    const quint64 tileByteCountsOffset = tileOffsetsOffset + offsetSize * tileCount;
+    const quint64 tilesOffset = tileByteCountsOffset + offsetSize * tileCount;
+    const TiffType offsetType = bigTiff ? Long8 : Long;
+
+    const TiffEntry entries[entryCount] = {
+        {imageWidthTag, Long, 1, static_cast<quint64>(w)},
+        {imageLengthTag, Long, 1, static_cast<quint64>(h)},
+        {bitsPerSampleTag, Short, 3, bigTiff ? 0x0000000800080008ull : bitsPerSampleOffset},
+        {compressionTag, Short, 1, 1},                  // none
+        {photometricInterpretationTag, Short, 1, 2},    // RGB
+        {samplesPerPixelTag, Short, 1, 3},
+        {planarConfigurationTag, Short, 1, 1},          // RGBRGB...
+        {tileWidthTag, Long, 1, static_cast<quint64>(tileSize)},
+        {tileLengthTag, Long, 1, static_cast<quint64>(tileSize)},
+        {tileOffsetsTag, offsetType, static_cast<quint64>(tileCount), tileOffsetsOffset},
+        {tileByteCountsTag, offsetType, static_cast<quint64>(tileCount), tileByteCountsOffset}
+    };
+
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData("II", 2);
+    if (bigTiff) {
+        stream << quint16(43) << quint16(8) << quint16(0) << directoryOffset;
+        stream << quint64(entryCount);
+    }
+    else {
+        stream << quint16(42) << quint32(directoryOffset);
+        stream << quint16(entryCount);
+    }
+
+    // values are left aligned in the value field, a single short is its first two bytes
+    for (const TiffEntry& entry : entries) {
+        stream << entry.tag << entry.type;
+        if (bigTiff) {
+            stream << entry.count << entry.value;
+        }
+        else if (entry.type == Short && entry.count == 1) {
+            stream << quint32(entry.count) << quint16(entry.value) << quint16(0);
+        }
+        else {
+            stream << quint32(entry.count) << quint32(entry.value);
+        }
+    }
+    if (bigTiff) stream << quint64(0);
+    else stream << quint32(0);
+
+    if (!bigTiff) stream << quint16(8) << quint16(8) << quint16(8);
+    for (int tile = 0; tile < tileCount; tile++) {
+        const quint64 offset = tilesOffset + tile * tileByteCount();
+        if (bigTiff) stream << offset;
+        else stream << quint32(offset);
+    }
+    for (int tile = 0; tile < tileCount; tile++) {
+        if (bigTiff) stream << tileByteCount();
+        else stream << quint32(tileByteCount());
+    }
+    return bytes;
+}
+
+bool TiledTiffWriter::open()
+{
+    QMutexLocker locker(&mutex);
+    if (w <= 0 || h <= 0 || tileSize <= 0 || tileSize % 16 != 0) {
+        errorString = "Invalid image or tile size";
+        return false;
+    }
+
+    const QByteArray headerBytes = header();
+    firstTileOffset = headerBytes.size();
+    const quint64 fileSize = firstTileOffset + tileCount * tileByteCount();
+
+    resumed = file.exists() && file.size() == static_cast<qint64>(fileSize) && readProgress();
+    if (!resumed) {
+        writtenTiles.fill(false);
+        writtenTileCount = 0;
+    }
+
+    // the file is allocated at its full size, the tiles not written yet read as black
+    if (!file.open(QIODevice::ReadWrite) || (!resumed && (!file.resize(0) || !file.resize(fileSize))) ||
+        file.write(headerBytes) != headerBytes.size()) {
+        errorString = file.errorString();
+        return false;
+    }
+
+    if (!progressFile.open(resumed ? QIODevice::ReadWrite | QIODevice::Append : QIODevice::WriteOnly | QIODevice::Truncate)) {
+        errorString = progressFile.errorString();
+        return false;
+    }
+    if (!resumed) {
+        ProgressHeader progressHeader;
+        memset(&progressHeader, 0, sizeof(progressHeader));
+        memcpy(progressHeader.magic, progressMagic, sizeof(progressMagic));
+        progressHeader.version = progressVersion;
+        progressHeader.w = w;
+        progressHeader.h = h;
+        progressHeader.tileSize = tileSize;
+        progressHeader.signature = signature;
+        progressFile.write(reinterpret_cast<const char*>(&progressHeader), sizeof(progressHeader));
+        progressFile.flush();
+    }
+    return true;
+}
+
+// a tile index that was cut off by an interruption is dropped, that tile is traced again
+bool TiledTiffWriter::readProgress()
+{
+    if (!progressFile.open(QIODevice::ReadOnly)) return false;
+    const QByteArray bytes = progressFile.readAll();
+    progressFile.close();
+    if (bytes.size() < static_cast<int>(sizeof(ProgressHeader))) return false;
+
+    ProgressHeader progressHeader;
+    memcpy(&progressHeader, bytes.constData(), sizeof(progressHeader));
+    if (memcmp(progressHeader.magic, progressMagic, sizeof(progressMagic)) != 0 ||
+        progressHeader.version != progressVersion || progressHeader.w != static_cast<quint32>(w) ||
+        progressHeader.h != static_cast<quint32>(h) || progressHeader.tileSize != static_cast<quint32>(tileSize) ||
+        progressHeader.signature != signature) {
+        return false;
+    }
+
+    writtenTiles.fill(false);
+    writtenTileCount = 0;
+    const int indexCount = (bytes.size() - static_cast<int>(sizeof(ProgressHeader))) / sizeof(quint32);
+    for (int i = 0; i < indexCount; i++) {
+        quint32 tile;
+        memcpy(&tile, bytes.constData() + sizeof(ProgressHeader) + i * sizeof(quint32), sizeof(tile));
+        if (tile >= static_cast<quint32>(tileCount) || writtenTiles.testBit(tile)) continue;
+        writtenTiles.setBit(tile);
+        writtenTileCount++;
+    }
+    if (!progressFile.resize(sizeof(ProgressHeader) + indexCount * sizeof(quint32))) return false;
+    return true;
+}
+
+QString TiledTiffWriter::getErrorString() const
+{
+    QMutexLocker locker(&mutex);
+    return errorString;
+}
+
+int TiledTiffWriter::getTileCount() const
+{
+    return tileCount;
+}
+
+int TiledTiffWriter::getWrittenTileCount() const
+{
+    QMutexLocker locker(&mutex);
+    return writtenTileCount;
+}
+
+bool TiledTiffWriter::isTileWritten(const int tile) const
+{
+    QMutexLocker locker(&mutex);
+    return writtenTiles.testBit(tile);
+}
+
+/*
+ * The tile is flushed to the file before its index is logged, so a logged tile is in the file if the program is
+ * interrupted right after. The data is not synced to the disk for each tile though: after a crash of the system, a
+ * logged tile may be missing and stays black when the render continues.
+ */
+bool TiledTiffWriter::writeTile(const int tile, const QImage& pixels)
+{
+    QByteArray rgb(static_cast<int>(tileByteCount()), '\0');
+    const int rows = std::min(tileSize, pixels.height());
+    const int columns = std::min(tileSize, pixels.width());
+    for (int row = 0; row < rows; row++) {
+        const QRgb* line = reinterpret_cast<const QRgb*>(pixels.constScanLine(row));
+        char* out = rgb.data() + row * tileSize * 3;
+        for (int column = 0; column < columns; column++) {
+            out[column * 3] = static_cast<char>(qRed(line[column]));
+            out[column * 3 + 1] = static_cast<char>(qGreen(line[column]));
+            out[column * 3 + 2] = static_cast<char>(qBlue(line[column]));
+        }
+    }
+
+    QMutexLocker locker(&mutex);
+    const quint32 index = tile;
+    if (!file.seek(firstTileOffset + tile * tileByteCount()) || file.write(rgb) != rgb.size() || !file.flush() ||
+        progressFile.write(reinterpret_cast<const char*>(&index), sizeof(index)) != sizeof(index) ||
+        !progressFile.flush()) {
+        errorString = file.error() != QFileDevice::NoError ? file.errorString() : progressFile.errorString();
+        return false;
+    }
+    if (!writtenTiles.testBit(tile)) {
+        writtenTiles.setBit(tile);
+        writtenTileCount++;
+    }
+    return true;
+}
+
+bool TiledTiffWriter::finish()
+{
+    QMutexLocker locker(&mutex);
+    file.close();
+    progressFile.close();
+    if (writtenTileCount != tileCount) return false;
+    progressFile.remove();
+    return true;
+}
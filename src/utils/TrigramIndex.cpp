@@ -0,0 +1,91 @@
+/*                   T R I G R A M I N D E X . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file TrigramIndex.cpp */
+
+#include <algorithm>
+#include "TrigramIndex.h"
+
+
+void TrigramIndex::add(int id, const QString& text)
+{
+    const int index = ids.size();
+    const QString lowerText = text.toLower();
+    ids.append(id);
+    texts.append(lowerText);
+
+    const QChar* c = lowerText.constData();
+    for (int i = 0; i + 2 < lowerText.size(); i++) {
+        QVector<int>& posting = postings[trigram(c + i)];
+        // the same trigram can appear several times in one text
+        if (posting.isEmpty() || posting.last() != index) posting.append(index);
+    }
+}
+
+void TrigramIndex::clear()
+{
+    ids.clear();
+    texts.clear();
+    postings.clear();
+}
+
+QVector<int> TrigramIndex::search(const QString& query) const
+{
+    QVector<int> result;
+    const QString lowerQuery = query.toLower();
+    if (lowerQuery.isEmpty()) return result;
+
+    if (lowerQuery.size() < 3) {
+        for (int i = 0; i < texts.size(); i++) {
+            if (texts[i].contains(lowerQuery)) result.append(ids[i]);
+        }
+        return result;
+    }
+
+    // collect the posting lists and start intersecting from the shortest one
+    QVector<const QVector<int>*> lists;
+    const QChar* c = lowerQuery.constData();
+    for (int i = 0; i + 2 < lowerQuery.size(); i++) {
+        QHash<quint64, QVector<int>>::const_iterator it = postings.constFind(trigram(c + i));
+        if (it == postings.constEnd()) return result;
+        lists.append(&it.value());
+    }
+    std::sort(lists.begin(), lists.end(), [](const QVector<int>* a, const QVector<int>* b) {
+        return a->size() < b->size();
+    });
+
+    QVector<int> candidates = *lists[0];
+    for (int list = 1; list < lists.size() && !candidates.isEmpty(); list++) {
+        const QVector<int>& other = *lists[list];
+        QVector<int> intersection;
+        int j = 0;
+        for (int candidate : candidates) {
+            while (j < other.size() && other[j] < candidate) j++;
+            if (j == other.size()) break;
+            if (other[j] == candidate) intersection.append(candidate);
+        }
+        candidates = intersection;
+    }
+
+    // every trigram being present doesn't mean they are in the right order
+    for (int index : candidates) {
+        if (lowerQuery.size() == 3 || texts[index].contains(lowerQuery)) result.append(ids[index]);
+    }
+    return result;
+}
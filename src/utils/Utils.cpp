@@ -151,7 +151,7 @@ bool getObjectNameFromUser(QWidget* parent, Document& document, QString& name) {
             if (name.isEmpty()) {
                 QMessageBox::information(parent, QObject::tr("Object Name"), QObject::tr("Please enter an object name"), QMessageBox::Ok);
             }
-            else if (document.getDatabase()->Get(name.toUtf8().data())) {
+            else if (document.containsObject(name)) {
                 QMessageBox::information(parent, QObject::tr("Object Name"), QObject::tr("Please enter an unique object name"), QMessageBox::Ok);
             }
             else {
@@ -217,4 +217,10 @@ QString* generateUUID(const QString& filepath) {
 
     ret = new QString(uuid_str);
     return ret;
-}
\ No newline at end of file
+}
+
+QString getCacheFolder() {
+    char cache[MAXPATHLEN];
+    bu_dir(cache, MAXPATHLEN, BU_DIR_CACHE, ".atr", NULL);
+    return QString(cache);
+}
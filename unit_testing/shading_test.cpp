@@ -0,0 +1,82 @@
+/*                   S H A D I N G _ T E S T . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file shading_test.cpp */
+
+/*
+ * Checks that shadeHits, with whatever SIMD path the compiler targets, colors random hits like shadeHitsScalar. The
+ * counts include ones that are not a multiple of the vector width, so the scalar remainder is covered as well.
+ * Exits with 1 if a channel differs by more than 1.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include "RaytraceShading.h"
+
+int main()
+{
+    const int counts[] = {1, 3, 4, 7, 8, 9, 15, 16, 17, 63, 64, 1000, 1156};
+    const QRgb background = qRgb(17, 34, 51);
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+
+    int failedCount = 0;
+    for (const int count : counts) {
+        for (int run = 0; run < 8; run++) {
+            QVector3D direction(uniform(random), uniform(random), uniform(random));
+            direction.normalize();
+
+            RayHits hits;
+            hits.resize(count);
+            for (int i = 0; i < count; i++) {
+                QVector3D normal(uniform(random), uniform(random), uniform(random));
+                normal.normalize();
+                // misses keep the values of a hit, like a reused RayHits does
+                hits.set(i, normal, (uniform(random) + 1.f) / 2.f, (uniform(random) + 1.f) / 2.f,
+                         (uniform(random) + 1.f) / 2.f, 100.f * (uniform(random) + 1.f), 1u + random() % 7);
+                if (random() % 5 == 0) hits.setMissed(i);
+            }
+
+            QVector<QRgb> colors(count);
+            QVector<QRgb> expected(count);
+            shadeHits(hits, count, direction, background, colors.data());
+            shadeHitsScalar(hits, count, direction, background, expected.data());
+
+            for (int i = 0; i < count; i++) {
+                const bool differs = std::abs(qRed(colors[i]) - qRed(expected[i])) > 1 ||
+                                     std::abs(qGreen(colors[i]) - qGreen(expected[i])) > 1 ||
+                                     std::abs(qBlue(colors[i]) - qBlue(expected[i])) > 1 ||
+                                     qAlpha(colors[i]) != qAlpha(expected[i]);
+                if (!differs) continue;
+                if (failedCount < 10) {
+                    printf("count %d, hit %d: %08x instead of %08x\n", count, i, colors[i], expected[i]);
+                }
+                failedCount++;
+            }
+        }
+    }
+
+    if (failedCount > 0) {
+        printf("%d colors differ from the scalar shading\n", failedCount);
+        return 1;
+    }
+    printf("shadeHits matches the scalar shading\n");
+    return 0;
+}
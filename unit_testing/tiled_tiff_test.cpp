@@ -0,0 +1,127 @@
+/*                T I L E D _ T I F F _ T E S T . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2023 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file tiled_tiff_test.cpp */
+
+/*
+ * Writes part of the tiles of an image, opens the file again as an interrupted render would, writes the rest and reads
+ * the file back with QImageReader. Done for the classic TIFF and the BigTIFF layout, the image size is not a multiple
+ * of the tile size, so the edge tiles are cut off. Exits with 1 if anything differs.
+ */
+
+#include <cstdio>
+#include <QCoreApplication>
+#include <QFile>
+#include <QImage>
+#include <QImageReader>
+#include <QTemporaryDir>
+#include "TiledTiffWriter.h"
+
+namespace {
+    const int w = 100;
+    const int h = 70;
+    const int tileSize = 32;
+    const quint64 signature = 0x1234;
+
+    QRgb pixelColor(const int x, const int y)
+    {
+        return qRgb(x * 2, y * 3, (x + y) % 256);
+    }
+
+    bool writeTiles(TiledTiffWriter& writer, const int first, const int end)
+    {
+        const int tilesPerRow = (w + tileSize - 1) / tileSize;
+        QImage tile(tileSize, tileSize, QImage::Format_RGB32);
+        for (int index = first; index < end; index++) {
+            if (writer.isTileWritten(index)) continue;
+            const int left = index % tilesPerRow * tileSize;
+            const int top = index / tilesPerRow * tileSize;
+            for (int y = 0; y < tileSize; y++) {
+                for (int x = 0; x < tileSize; x++) tile.setPixel(x, y, pixelColor(left + x, top + y));
+            }
+            if (!writer.writeTile(index, tile)) return false;
+        }
+        return true;
+    }
+
+    bool check(const QString& filePath, const bool bigTiff)
+    {
+        const char* layout = bigTiff ? "BigTIFF" : "classic TIFF";
+        int tileCount;
+        {
+            TiledTiffWriter writer(filePath, w, h, tileSize, signature);
+            if (bigTiff) writer.forceBigTiff();
+            tileCount = writer.getTileCount();
+            if (!writer.open() || writer.isResumed() || !writeTiles(writer, 0, tileCount / 2)) {
+                printf("%s: writing the first tiles failed: %s\n", layout, qPrintable(writer.getErrorString()));
+                return false;
+            }
+            // interrupted, the files are closed without finish()
+        }
+
+        TiledTiffWriter writer(filePath, w, h, tileSize, signature);
+        if (bigTiff) writer.forceBigTiff();
+        if (!writer.open() || !writer.isResumed() || writer.getWrittenTileCount() != tileCount / 2 ||
+            writer.isTileWritten(tileCount / 2) || !writer.isTileWritten(tileCount / 2 - 1)) {
+            printf("%s: the written tiles were not resumed\n", layout);
+            return false;
+        }
+        if (!writeTiles(writer, 0, tileCount) || !writer.finish() || QFile::exists(filePath + ".progress")) {
+            printf("%s: finishing failed: %s\n", layout, qPrintable(writer.getErrorString()));
+            return false;
+        }
+
+        QImageReader reader(filePath);
+        const QImage image = reader.read();
+        if (image.isNull()) {
+            printf("%s: QImageReader can not read the file: %s\n", layout, qPrintable(reader.errorString()));
+            return false;
+        }
+        if (image.width() != w || image.height() != h) {
+            printf("%s: read a %dx%d image\n", layout, image.width(), image.height());
+            return false;
+        }
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                if ((image.pixel(x, y) & 0xffffff) == (pixelColor(x, y) & 0xffffff)) continue;
+                printf("%s: pixel %d, %d is %08x instead of %08x\n", layout, x, y, image.pixel(x, y),
+                       pixelColor(x, y));
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // image plugins are looked up through the application
+    QCoreApplication app(argc, argv);
+    QTemporaryDir directory;
+    if (!directory.isValid()) {
+        printf("Failed to create a temporary directory\n");
+        return 1;
+    }
+
+    const bool classicTiff = check(directory.filePath("classic.tif"), false);
+    const bool bigTiff = check(directory.filePath("big.tif"), true);
+    if (!classicTiff || !bigTiff) return 1;
+    printf("Resumed tiled TIFF files read back correctly\n");
+    return 0;
+}